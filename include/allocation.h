@@ -0,0 +1,14 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <stddef.h>
+
+/**
+ * realloc que encerra o programa quando falta memória, como as outras
+ * alocações do compilador.
+ * @param message A mensagem passada a perror, como "Error allocating symbol table".
+ * @return O novo endereço, nunca NULL.
+ */
+void *checked_realloc(void *pointer, size_t size, const char *message);
+
+#endif // ALLOCATION_H
@@ -0,0 +1,52 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_INITIAL_CAPACITY (64 << 10)
+#define ARENA_ALIGNMENT 8
+
+/**
+ * Região de memória contígua com alocação sequencial (bump allocation).
+ * As alocações são identificadas pelo offset de 32 bits em data, e não por
+ * ponteiros, porque a região é realocada quando cresce. Tudo o que foi
+ * alocado é liberado de uma vez, em arena_reset ou arena_free.
+ */
+typedef struct
+{
+    char *data;
+    uint32_t size;
+    uint32_t capacity;
+} Arena;
+
+void arena_init(Arena *arena);
+
+/**
+ * Reserva size bytes zerados, alinhados a ARENA_ALIGNMENT.
+ * @return O offset da alocação. Ponteiros obtidos antes da chamada deixam de ser válidos.
+ */
+uint32_t arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @return O endereço atual da alocação em offset.
+ */
+static inline void *arena_at(const Arena *arena, uint32_t offset)
+{
+    return arena->data + offset;
+}
+
+/**
+ * Descarta as alocações feitas a partir de offset, que deve ter sido devolvido
+ * por arena_alloc. As anteriores continuam válidas.
+ */
+void arena_rewind(Arena *arena, uint32_t offset);
+
+/**
+ * Descarta todas as alocações, mantendo a memória para reutilização.
+ */
+void arena_reset(Arena *arena);
+
+void arena_free(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,120 @@
+#ifndef AST_H
+#define AST_H
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "token.h"
+
+typedef uint32_t AstIndex;
+
+#define AST_NONE 0 // O nó 0 é reservado e indica a ausência de um nó
+
+typedef enum
+{
+    AST_EMPTY,           // Comando vazio
+    AST_PROGRAM,         // Nome, bloco
+    AST_BLOCK,           // Declarações de variáveis, subrotinas, comando composto
+    AST_VAR_DECLARATION, // Identificadores; op é o tipo
+    AST_PROCEDURE,       // Nome, parâmetros (AST_VAR_DECLARATION), bloco
+    AST_FUNCTION,        // Nome, parâmetros (AST_VAR_DECLARATION), bloco; op é o tipo do resultado
+    AST_COMPOUND,        // Comandos
+    AST_ASSIGNMENT,      // Variável, expressão
+    AST_CALL,            // Nome da subrotina, argumentos
+    AST_IF,              // Condição, comando do then, comando do else (opcional)
+    AST_WHILE,           // Condição, comando
+    AST_WRITE,           // Variáveis
+    AST_BINARY,          // Operando esquerdo, operando direito; op é o operador
+    AST_UNARY,           // Operando; op é o operador (sinal ou not)
+    AST_IDENTIFIER,      // symbol é o ID do nome; nos usos, op é o tipo da declaração visível
+    AST_NUMBER,          // value é o valor, módulo 2^32
+    AST_BOOLEAN,         // op é BOOL_TRUE ou BOOL_FALSE
+    AST_ERROR,           // Trecho com erro de sintaxe, no lugar do nó esperado
+} AstKind;
+
+#define AST_FLAG_PARAMETER 0x0001  // AST_VAR_DECLARATION de parâmetros formais
+#define AST_FLAG_VARIABLE 0x0002   // AST_IDENTIFIER usado que nomeia uma variável ou parâmetro declarado; op é o tipo
+#define AST_FLAG_SUBROUTINE 0x0004 // AST_IDENTIFIER usado que nomeia uma subrotina declarada; op é o tipo do resultado
+
+/**
+ * Nó da árvore sintática, com 16 bytes. Os filhos de um nó formam uma lista
+ * encadeada: first aponta para o primeiro e next de cada filho para o
+ * seguinte. Folhas usam o mesmo campo para o símbolo ou o valor.
+ */
+typedef struct
+{
+    uint8_t kind;    // AstKind
+    int8_t op;       // TokenKind do operador, tipo ou literal, ou TOKEN_KIND_NONE
+    uint16_t flags;
+    uint32_t offset; // Posição do token que origina o nó no código-fonte
+    union
+    {
+        AstIndex first; // Primeiro filho
+        uint32_t symbol;
+        uint32_t value;
+    };
+    AstIndex next;   // Próximo irmão
+} AstNode;
+
+/**
+ * Árvore sintática de uma compilação. Os nós ficam em sequência em uma arena
+ * e são liberados todos juntos em ast_free.
+ */
+typedef struct
+{
+    Arena arena;
+    uint32_t count;
+} Ast;
+
+/**
+ * Lista de filhos em construção.
+ */
+typedef struct
+{
+    AstIndex first;
+    AstIndex last;
+} AstList;
+
+void ast_init(Ast *ast);
+
+/**
+ * Remove todos os nós, mantendo a memória da arena para reutilização.
+ * Também serve para inicializar uma árvore zerada.
+ */
+void ast_reset(Ast *ast);
+
+/**
+ * Substitui a árvore por count nós já construídos, a partir do nó 0 reservado,
+ * como os guardados pelo cache de compilações.
+ */
+void ast_load(Ast *ast, const void *nodes, uint32_t count);
+
+/**
+ * Adiciona um nó sem filhos.
+ * @return O índice do nó. Ponteiros obtidos com ast_node antes da chamada deixam de ser válidos.
+ */
+AstIndex ast_add(Ast *ast, AstKind kind, TokenKind op, uint32_t offset);
+
+static inline AstNode *ast_node(const Ast *ast, AstIndex index)
+{
+    return (AstNode *)ast->arena.data + index;
+}
+
+/**
+ * Adiciona node ao final da lista.
+ */
+void ast_list_append(const Ast *ast, AstList *list, AstIndex node);
+
+/**
+ * Adiciona um nó cujos filhos são os nós da lista.
+ */
+AstIndex ast_add_list(Ast *ast, AstKind kind, TokenKind op, uint32_t offset, const AstList *children);
+
+/**
+ * @return O nome do tipo de nó.
+ */
+const char *ast_kind_to_string(AstKind kind);
+
+void ast_free(Ast *ast);
+
+#endif // AST_H
@@ -0,0 +1,52 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+
+#include "compiler_context.h"
+
+/*
+Compilação de vários arquivos em um único processo.
+
+Os arquivos são distribuídos, do maior para o menor, entre as filas de um
+conjunto fixo de threads. Cada thread reutiliza o mesmo CompilerContext para
+todos os seus arquivos e, quando a sua fila esvazia, rouba arquivos da fila
+de outra thread. Os diagnósticos de cada arquivo são guardados em memória e
+escritos na ordem da entrada, seguidos do resultado e do tempo do arquivo.
+*/
+
+/**
+ * Lista dos arquivos de entrada.
+ */
+typedef struct
+{
+    char **files;
+    int count;
+    int capacity;
+} BatchInputs;
+
+void batch_inputs_init(BatchInputs *inputs);
+
+void batch_inputs_add(BatchInputs *inputs, const char *filename);
+
+/**
+ * Adiciona os arquivos listados em um arquivo de respostas (@arquivo na linha
+ * de comando), um por linha. Linhas vazias e linhas iniciadas por '#' são ignoradas.
+ * @return false se o arquivo não puder ser lido.
+ */
+bool batch_inputs_add_response_file(BatchInputs *inputs, const char *filename);
+
+void batch_inputs_free(BatchInputs *inputs);
+
+/**
+ * Analisa todos os arquivos e escreve os diagnósticos, o resultado e o tempo
+ * de cada um em options->output, na ordem da entrada, seguidos de um resumo.
+ * @param options As opções de cada compilação. Com uma sink que registra
+ *                tokens, o log de cada arquivo é <arquivo>.<extensão da sink>.
+ * @param workers Quantidade de threads.
+ * @param replay Se os arquivos são logs binários a reproduzir.
+ * @return true se nenhum arquivo tem erros.
+ */
+bool batch_compile(const BatchInputs *inputs, const CompilerOptions *options, int workers, bool replay);
+
+#endif // BATCH_H
@@ -0,0 +1,85 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/*
+Cache de compilações em disco.
+
+Cada entrada é um arquivo <chave>.entry no diretório do cache, com a saída da
+compilação (diagnósticos e eco dos tokens), o log de tokens, a árvore sintática
+e os nomes dos símbolos. A chave é um hash de 128 bits do código-fonte, da versão
+do compilador e das opções que mudam a saída (formato do log, eco e limite de
+erros). Em um acerto, a saída e o log são reproduzidos e a árvore é carregada
+sem que o scanner e o parser sejam executados.
+
+As entradas são escritas em um arquivo temporário e renomeadas, então vários
+processos podem compartilhar o mesmo diretório: quem lê vê uma entrada
+completa ou nenhuma. Cada acerto atualiza a data de modificação da entrada, e
+quando o diretório passa do limite de tamanho as entradas usadas há mais tempo
+são removidas (LRU).
+
+Só compilações que chegam ao fim são guardadas: erros léxicos, erros de sintaxe
+demais e falhas de leitura são sempre refeitos.
+*/
+
+#define COMPILE_CACHE_DEFAULT_LIMIT (256ull << 20)
+
+/**
+ * Diretório do cache, compartilhado pelos contextos de um processo.
+ */
+typedef struct
+{
+    char *directory;
+    uint64_t limit; // Tamanho máximo das entradas, em bytes
+    uint64_t size;  // Tamanho estimado das entradas, recalculado a cada remoção
+
+    pthread_mutex_t lock; // Protege size e a remoção de entradas
+    uint32_t sequence;    // Distingue os arquivos temporários das threads do processo
+} CompileCache;
+
+/**
+ * Entrada em construção durante uma compilação que não estava no cache.
+ */
+typedef struct
+{
+    bool active;
+    uint64_t key[2];
+
+    FILE *output; // options.output original, enquanto a saída é capturada
+    FILE *capture;
+    char *text;
+    size_t text_size;
+} CompileCacheEntry;
+
+typedef struct CompilerContext CompilerContext;
+
+/**
+ * Usa directory como cache, criando-o se não existir.
+ * @param limit O tamanho máximo das entradas, em bytes.
+ * @return false se o diretório não puder ser criado.
+ */
+bool compile_cache_open(CompileCache *cache, const char *directory, uint64_t limit);
+
+void compile_cache_close(CompileCache *cache);
+
+/**
+ * Procura o código-fonte do scanner no cache de options.cache. Em um acerto,
+ * escreve a saída guardada em options.output, o log de tokens guardado no
+ * arquivo de log e restaura a árvore sintática e a tabela de símbolos. Em uma
+ * falta, passa a capturar a saída da compilação para compile_cache_finish.
+ * @return true se a compilação foi encontrada.
+ */
+bool compile_cache_load(CompilerContext *context);
+
+/**
+ * Termina a captura iniciada por compile_cache_load: escreve a saída capturada
+ * em options.output e, se a compilação chegou ao fim, grava a entrada.
+ */
+void compile_cache_finish(CompilerContext *context, bool completed);
+
+#endif // COMPILE_CACHE_H
@@ -0,0 +1,117 @@
+#ifndef COMPILER_CONTEXT_H
+#define COMPILER_CONTEXT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+#include "symbol_table.h"
+#include "scanner.h"
+#include "parser.h"
+#include "logging.h"
+#include "log_sink.h"
+#include "token_dump.h"
+#include "compile_cache.h"
+#include "type_check.h"
+#include "constant_fold.h"
+
+/*
+Contexto de compilação.
+
+Todo o estado de uma compilação (tabela de símbolos, scanner, parser e log)
+fica em um CompilerContext, recebido por todas as funções do scanner, do
+parser e do log. Compilações com contextos diferentes são independentes e
+podem rodar ao mesmo tempo em threads diferentes; um mesmo contexto só pode
+ser usado por uma thread de cada vez.
+
+Os erros que antes terminavam o programa (arquivo inexistente, erro léxico,
+erros de sintaxe demais) interrompem apenas a compilação: compiler_fail volta
+para compiler_compile ou compiler_replay, que devolvem false. Falhas de
+alocação de memória ainda terminam o programa.
+*/
+
+/**
+ * Opções de uma compilação, preenchidas antes de compiler_compile.
+ */
+typedef struct
+{
+    const char *log_name; // Prefixo do arquivo de log: <log_name>.<extensão da sink>
+    const LogSink *sink;  // Formato do log de tokens
+    bool echo;            // Se os tokens também são escritos em output, quando a sink permite
+    int threads;          // Threads usadas para analisar arquivos grandes
+    int max_errors;       // Erros de sintaxe registrados antes de interromper a análise, ou 0 para nenhum limite
+    FILE *output;         // Onde os erros (e o eco dos tokens) são escritos
+    CompileCache *cache;  // Cache de compilações em disco, ou NULL
+    bool fold;            // Se as árvores sem erros passam por constant_fold
+} CompilerOptions;
+
+struct CompilerContext
+{
+    CompilerOptions options;
+    SymbolTable symbol_table; // Identificadores internados pelo scanner
+    Scanner scanner;
+    Parser parser;
+    TypeTable types; // Tipo de cada nó da árvore, calculado por type_check
+    Logger logger;
+    TokenDump dump;  // Log binário reproduzido por compiler_replay
+    jmp_buf failure; // Destino de compiler_fail, definido durante a compilação
+    bool editable;   // A última compilação terminou com o código-fonte inteiro na memória
+    uint32_t folded; // Nós removidos por constant_fold na última compilação ou edição
+
+    CompileCacheEntry cache_entry; // Entrada de options.cache em construção
+};
+
+/**
+ * Prepara um contexto com as opções padrão: sem log, uma única thread,
+ * PARSER_DEFAULT_MAX_ERRORS e erros na saída padrão.
+ */
+void compiler_context_init(CompilerContext *context);
+
+/**
+ * Analisa o arquivo (ou "-", a entrada padrão). A árvore sintática e a tabela
+ * de símbolos continuam disponíveis até a próxima compilação ou compiler_context_free.
+ * @return true se o programa não tem erros.
+ */
+bool compiler_compile(CompilerContext *context, const char *source_filename);
+
+/**
+ * Analisa um código-fonte que já está na memória, como compiler_compile.
+ * @param source Memória alocada com malloc, que passa a pertencer ao contexto.
+ */
+bool compiler_compile_source(CompilerContext *context, char *source, size_t size);
+
+/**
+ * Analisa os tokens de um log binário (--log=binary) em vez do código-fonte.
+ * Nenhum log de tokens é escrito, para não sobrescrever o arquivo reproduzido.
+ * Os símbolos da árvore sintática são IDs das strings do log, mapeado até a próxima compilação.
+ * @return true se o programa não tem erros.
+ */
+bool compiler_replay(CompilerContext *context, const char *dump_filename);
+
+/**
+ * Aplica uma edição ao código-fonte da última compilação e atualiza a árvore
+ * sintática. Se a edição estiver dentro de uma declaração de subrotina, só
+ * essa declaração é analisada de novo (parser_reparse); do contrário, se a
+ * última compilação teve erros ou se o resultado puder ser diferente do de
+ * uma análise completa, o código-fonte editado é analisado inteiro, como em
+ * compiler_compile_source. Nenhum log de tokens é escrito. Só compilações
+ * terminadas de um código-fonte na memória (não lido em fluxo nem reproduzido
+ * de um log) podem ser editadas.
+ * @param offset O início do trecho substituído.
+ * @param removed Quantos bytes são removidos a partir de offset.
+ * @param text Os bytes inseridos no lugar do trecho.
+ * @param inserted Quantos bytes de text são inseridos.
+ * @return true se o programa editado não tem erros; false também se a edição
+ *         for inválida ou se não houver uma compilação a editar.
+ */
+bool compiler_edit(CompilerContext *context, uint32_t offset, uint32_t removed, const char *text, uint32_t inserted);
+
+/**
+ * Interrompe a compilação em andamento depois de um erro já registrado.
+ */
+__attribute__((noreturn)) void compiler_fail(CompilerContext *context);
+
+void compiler_context_free(CompilerContext *context);
+
+#endif // COMPILER_CONTEXT_H
@@ -0,0 +1,38 @@
+#ifndef CONSTANT_FOLD_H
+#define CONSTANT_FOLD_H
+
+#include <stdint.h>
+
+#include "ast.h"
+
+/*
+Dobra de constantes.
+
+Como type_check, percorre a arena da árvore uma vez pelos índices: os filhos de
+cada nó já estão dobrados quando ele é visitado. Um nó dobrado é reescrito no
+próprio lugar, mantendo o next, então o pai continua apontando para ele:
+
+- Operações com operandos constantes viram AST_NUMBER ou AST_BOOLEAN. A
+  aritmética é a de inteiros de 32 bits com sinal, módulo 2^32 (como os
+  literais); div trunca em direção a zero, o menor inteiro div -1 é ele mesmo,
+  e uma divisão por zero fica na árvore, para acontecer na execução.
+- Identidades: x + 0, 0 + x, x - 0, x * 1, 1 * x, x div 1, x and true,
+  true and x, x or false, false or x, +x e not not x viram x.
+- if com condição constante vira o comando do ramo escolhido (ou AST_EMPTY),
+  e while com condição false vira AST_EMPTY.
+
+Os nós que deixam de ser alcançáveis continuam na arena, e a tabela de tipos
+acompanha as substituições.
+*/
+
+typedef struct CompilerContext CompilerContext;
+
+/**
+ * Dobra os nós de first até o último nó da árvore, que não pode ter erros
+ * e já passou por type_check.
+ * @param first AST_NONE + 1 para a árvore inteira, ou o primeiro nó criado por parser_reparse.
+ * @return Quantos nós deixaram de fazer parte da árvore.
+ */
+uint32_t constant_fold(CompilerContext *context, AstIndex first);
+
+#endif // CONSTANT_FOLD_H
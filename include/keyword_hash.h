@@ -0,0 +1,59 @@
+#ifndef KEYWORD_HASH_H
+#define KEYWORD_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "token.h"
+
+/**
+ * Entrada da tabela de palavras reservadas e operadores escritos por extenso.
+ * A tabela é gerada por tools/gen_keyword_table.c a partir das listas de src/token.c.
+ */
+typedef struct
+{
+    const char *word;
+    uint8_t length;
+    TokenType type;
+    TokenKind kind;
+} KeywordEntry;
+
+/**
+ * Hash FNV-1a do lexema. Compartilhado entre o gerador e o analisador léxico.
+ */
+static inline uint32_t keyword_hash(const char *start, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)start[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Posição final do lexema na tabela a partir do hash e do deslocamento do seu balde.
+ */
+static inline uint32_t keyword_slot(uint32_t hash, uint32_t displacement, uint32_t table_size)
+{
+    uint32_t mixed = hash ^ (displacement * 0x9e3779b9u);
+
+    mixed ^= mixed >> 16;
+    mixed *= 0x85ebca6bu;
+    mixed ^= mixed >> 13;
+
+    return mixed % table_size;
+}
+
+/**
+ * Procura um lexema com forma de identificador na tabela hash perfeita.
+ * @param start O ponteiro para o início do lexema.
+ * @param length O tamanho do lexema.
+ * @return A entrada correspondente ou NULL se o lexema for um identificador comum.
+ */
+const KeywordEntry *keyword_lookup(const char *start, size_t length);
+
+#endif // KEYWORD_HASH_H
@@ -0,0 +1,38 @@
+/* Gerado automaticamente por tools/gen_keyword_table.c a partir de src/token.c. Não edite. */
+
+#ifndef KEYWORD_TABLE_H
+#define KEYWORD_TABLE_H
+
+#include "keyword_hash.h"
+
+#define KEYWORD_TABLE_SIZE 20
+#define KEYWORD_BUCKET_COUNT 10
+#define KEYWORD_MIN_LENGTH 2
+#define KEYWORD_MAX_LENGTH 9
+
+static const uint16_t keyword_displacements[KEYWORD_BUCKET_COUNT] = {2, 0, 3, 15, 62, 0, 66, 0, 256, 0};
+
+static const KeywordEntry keyword_table[KEYWORD_TABLE_SIZE] = {
+    {"program", 7, TOKEN_KEYWORD, KW_PROGRAM},
+    {"and", 3, TOKEN_OPERATOR_LOGICAL, OP_AND},
+    {"else", 4, TOKEN_KEYWORD, KW_ELSE},
+    {"write", 5, TOKEN_KEYWORD, KW_WRITE},
+    {"function", 8, TOKEN_KEYWORD, KW_FUNCTION},
+    {"false", 5, TOKEN_BOOLEAN, BOOL_FALSE},
+    {"boolean", 7, TOKEN_KEYWORD, KW_BOOLEAN},
+    {"do", 2, TOKEN_KEYWORD, KW_DO},
+    {"true", 4, TOKEN_BOOLEAN, BOOL_TRUE},
+    {"end", 3, TOKEN_KEYWORD, KW_END},
+    {"var", 3, TOKEN_KEYWORD, KW_VAR},
+    {"integer", 7, TOKEN_KEYWORD, KW_INTEGER},
+    {"or", 2, TOKEN_OPERATOR_LOGICAL, OP_OR},
+    {"if", 2, TOKEN_KEYWORD, KW_IF},
+    {"while", 5, TOKEN_KEYWORD, KW_WHILE},
+    {"then", 4, TOKEN_KEYWORD, KW_THEN},
+    {"begin", 5, TOKEN_KEYWORD, KW_BEGIN},
+    {"procedure", 9, TOKEN_KEYWORD, KW_PROCEDURE},
+    {"div", 3, TOKEN_OPERATOR_ARITHMETIC, OP_DIV},
+    {"not", 3, TOKEN_OPERATOR_LOGICAL, OP_NOT},
+};
+
+#endif // KEYWORD_TABLE_H
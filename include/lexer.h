@@ -0,0 +1,71 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "token.h"
+
+typedef enum
+{
+    LEX_TOKEN,                // Um token foi reconhecido
+    LEX_COMMENT,              // Um comentário foi reconhecido (token TOKEN_COMMENT)
+    LEX_END,                  // O limite (ou o fim do código-fonte) foi alcançado
+    LEX_INVALID_CHARACTER,    // Nenhum token começa no caractere em token->offset
+    LEX_UNTERMINATED_COMMENT, // O comentário iniciado em token->offset não foi fechado
+    LEX_NEED_MORE,            // O trecho acabou no meio de um token ou comentário: é preciso ler mais código-fonte
+} LexResult;
+
+/**
+ * Estado do autômato léxico sobre um trecho do código-fonte.
+ * Não depende de nenhum estado global, então vários lexers podem
+ * percorrer partes diferentes do mesmo código-fonte ao mesmo tempo.
+ */
+typedef struct
+{
+    const char *source;   // Início do código-fonte (ou da janela de leitura), base dos offsets dos tokens
+    uint32_t base_offset; // Offset de source no código-fonte completo
+    const char *end;      // Fim do código-fonte (ou dos bytes já lidos para a janela)
+    const char *limit;    // Nenhum token ou comentário é iniciado a partir desta posição
+    const char *cursor;   // Próximo caractere a ser lido
+    bool at_eof;          // end é o fim do código-fonte; do contrário, LEX_NEED_MORE pede mais bytes
+
+    bool in_comment;         // Dentro de um comentário cujo início já saiu da janela
+    uint32_t comment_offset; // Offset do início desse comentário
+} Lexer;
+
+/**
+ * @param source O início do código-fonte.
+ * @param size O tamanho do código-fonte.
+ * @param start A posição a partir da qual os tokens são lidos.
+ * @param limit A posição a partir da qual nenhum token é iniciado.
+ */
+void lexer_init(Lexer *lexer, const char *source, size_t size, const char *start, const char *limit);
+
+/**
+ * Troca a janela de leitura de um lexer em fluxo. Os bytes a partir do cursor
+ * devem ter sido preservados na nova janela.
+ * @param source O início da nova janela.
+ * @param size Quantos bytes da janela foram lidos.
+ * @param base_offset O offset de source no código-fonte completo.
+ * @param cursor A posição do cursor na nova janela.
+ * @param at_eof Se o fim da janela é o fim do código-fonte.
+ */
+void lexer_set_window(Lexer *lexer, const char *source, size_t size, uint32_t base_offset, const char *cursor, bool at_eof);
+
+/**
+ * Continua o comentário iniciado no cursor sem mantê-lo inteiro na janela:
+ * o lexer só guarda o último caractere lido e o offset de início.
+ * Usado quando um comentário não cabe na janela de leitura.
+ */
+void lexer_skip_comment(Lexer *lexer);
+
+/**
+ * Reconhece o próximo token ou comentário. Identificadores não são internados.
+ * @param token Recebe o token ou comentário reconhecido, ou a posição do erro léxico.
+ * @return LEX_NEED_MORE, sem consumir o item incompleto, se a janela acabar antes do fim do código-fonte.
+ */
+LexResult lexer_next(Lexer *lexer, Token *token);
+
+#endif // LEXER_H
@@ -0,0 +1,57 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Índice das posições de início de cada linha do código-fonte.
+ * É construído com uma varredura vetorizada na primeira consulta, então
+ * programas sem diagnósticos nem log de tokens nunca pagam por ele.
+ *
+ * Na leitura em fluxo, as quebras de linha são adicionadas conforme os bytes
+ * são lidos, e as linhas que saem da janela de leitura são descartadas,
+ * mantendo a contagem em first_line. O scanner só mantém as linhas do
+ * comando em análise, cujos erros de tipo ainda não foram localizados
+ * (type_check_pending), então o índice não cresce com o código-fonte.
+ */
+typedef struct
+{
+    const char *source;
+    size_t size;
+
+    uint32_t *line_starts; // line_starts[i] é o offset do primeiro caractere da linha i + 1
+    uint32_t line_count;   // 0 enquanto o índice não foi construído
+    uint32_t capacity;     // Capacidade de line_starts na leitura em fluxo (0 no modo completo)
+    int first_line;        // Número da linha que começa em line_starts[0]
+    uint32_t hint;         // Linha da última consulta, já que as consultas costumam ser crescentes
+} LineIndex;
+
+void line_index_init(LineIndex *index, const char *source, size_t size);
+
+/**
+ * Inicializa um índice para a leitura em fluxo.
+ * @param capacity O tamanho da janela de leitura, o máximo de bytes de cada line_index_append.
+ */
+void line_index_init_stream(LineIndex *index, size_t capacity);
+
+/**
+ * Adiciona as quebras de linha de bytes recém-lidos na leitura em fluxo.
+ * @param base_offset O offset de data no código-fonte completo.
+ */
+void line_index_append(LineIndex *index, const char *data, size_t length, uint32_t base_offset);
+
+/**
+ * Descarta as linhas que terminam antes de offset, que saiu da janela de leitura.
+ */
+void line_index_discard(LineIndex *index, uint32_t offset);
+
+/**
+ * Converte um offset do código-fonte em linha e coluna, ambas a partir de 1.
+ * @param column Pode ser NULL.
+ */
+void line_index_locate(LineIndex *index, uint32_t offset, int *line, int *column);
+
+void line_index_free(LineIndex *index);
+
+#endif // LINE_INDEX_H
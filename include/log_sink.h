@@ -0,0 +1,83 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "token.h"
+
+#define LOG_OUTPUT_BUFFER 65536
+
+/**
+ * Saída com buffer próprio, escrita no arquivo apenas quando cheia ou em output_flush.
+ */
+typedef struct
+{
+    FILE *file;
+    void *state; // Estado da sink durante a escrita, criado em begin e liberado em end
+    size_t length;
+    char data[LOG_OUTPUT_BUFFER];
+} LogOutput;
+
+void output_write(LogOutput *output, const char *data, size_t length);
+
+void output_flush(LogOutput *output);
+
+typedef enum
+{
+    LOG_EVENT_TOKEN,
+    LOG_EVENT_LEXICAL_ERROR, // text é o caractere inválido
+    LOG_EVENT_SYNTAX_ERROR,  // text é o token inesperado
+    LOG_EVENT_END_OF_FILE,   // Erro de sintaxe no fim do arquivo
+    LOG_EVENT_SEMANTIC_ERROR, // text é a mensagem; offset e span são os do identificador
+    LOG_EVENT_END_OF_INPUT,  // O scanner chegou ao fim do código-fonte
+} LogEventKind;
+
+/**
+ * Um evento do log, com o texto já copiado para fora do código-fonte.
+ */
+typedef struct
+{
+    LogEventKind kind;
+    TokenType type;
+    int token_kind;
+    int line;
+    int column;
+    uint32_t offset;
+    uint32_t span; // Tamanho do token no código-fonte
+    const char *text;
+    uint32_t length; // Tamanho de text (comentários são limitados a MAX_COMMENT_LENGTH - 1 caracteres)
+} LogEvent;
+
+/**
+ * Formato do log de tokens. As funções são chamadas pela thread de escrita.
+ */
+typedef struct
+{
+    const char *name;      // Nome usado na linha de comando
+    const char *extension; // Sufixo do arquivo de log, ou NULL se nada é registrado
+    bool echo;             // Se o log pode ser repetido na saída padrão
+    void (*begin)(LogOutput *output);
+    void (*event)(LogOutput *output, const LogEvent *event);
+    void (*end)(LogOutput *output);
+} LogSink;
+
+extern const LogSink log_sink_null;
+extern const LogSink log_sink_text;
+extern const LogSink log_sink_jsonl;
+extern const LogSink log_sink_binary;
+
+/**
+ * @param name "none", "text", "jsonl" ou "binary".
+ * @return A sink com esse nome, ou NULL se não houver.
+ */
+const LogSink *log_sink_find(const char *name);
+
+/**
+ * Escreve a mensagem de um erro léxico, sintático ou semântico, como mostrada ao usuário.
+ */
+void log_write_diagnostic(LogOutput *output, const LogEvent *event);
+
+#endif // LOG_SINK_H
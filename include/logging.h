@@ -2,20 +2,108 @@
 #define LOGGING_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
 
 #include "token.h"
+#include "line_index.h"
+#include "log_sink.h"
 
 #define MAX_LOG_FILENAME 256
 #define MAX_LOG_LINE 512
 
-void log_init(const char *program_name);
+typedef struct CompilerContext CompilerContext;
+typedef union LogSlot LogSlot;
 
-void log_token(const Token *token);
+/**
+ * Estado do log de uma compilação. Os campos são usados apenas em logging.c.
+ */
+typedef struct
+{
+    const LogSink *sink;
+    bool active; // A sink registra eventos: há um arquivo de log e uma thread de escrita
+    FILE *file;
+    bool echo;
 
-void log_lexical_error(int line, char invalid_char);
+    const char *source;
+    uint32_t source_offset;
+    LineIndex *lines;
 
-void log_syntax_error(const Token *token);
+    LogSlot *ring;
+    uint64_t head;        // Próximo registro a ser escrito, publicado pelo produtor
+    uint64_t tail;        // Próximo registro a ser lido, publicado pelo consumidor
+    uint64_t cached_tail; // Cópia de tail vista pelo produtor
+    bool closing;
+    pthread_t writer_thread;
 
-void log_cleanup();
+    LogOutput *file_output;
+    LogOutput *stdout_output;
+
+    char *event_text; // Texto do evento sendo formatado, montado a partir das continuações
+    size_t event_text_capacity;
+} Logger;
+
+/**
+ * Abre o arquivo <log_name>.<extensão da sink> e inicia a thread que escreve o log,
+ * com a sink, o nome e o eco definidos nas opções do contexto.
+ * Com a sink nula, nenhum arquivo é criado e só os erros são escritos, em options.output.
+ */
+void log_init(CompilerContext *context);
+
+/**
+ * Define o código-fonte ao qual os offsets dos tokens se referem.
+ * @param source O código-fonte, ou a janela de leitura na leitura em fluxo.
+ * @param base_offset O offset de source no código-fonte completo.
+ * @param lines Índice usado para calcular linha e coluna apenas quando algo é registrado.
+ */
+void log_set_source(CompilerContext *context, const char *source, uint32_t base_offset, LineIndex *lines);
+
+void log_token(CompilerContext *context, const Token *token);
+
+/**
+ * Registra um token cujo início já saiu da janela de leitura, como um comentário longo.
+ * @param text O início do token, com pelo menos o tanto de texto que o log guarda.
+ * @param line A linha em que o token é registrado (a do fim, para comentários).
+ * @param column A coluna do início do token, calculada enquanto ele estava na janela.
+ */
+void log_token_at(CompilerContext *context, const Token *token, const char *text, int line, int column);
+
+/**
+ * @param offset A posição do caractere inválido no código-fonte.
+ */
+void log_lexical_error(CompilerContext *context, uint32_t offset);
+
+void log_syntax_error(CompilerContext *context, const Token *token);
+
+/**
+ * Registra um erro de sintaxe cuja posição e texto já são conhecidos,
+ * por exemplo ao reproduzir um log binário sem o código-fonte.
+ */
+void log_syntax_error_at(CompilerContext *context, const Token *token, int line, int column, const char *text);
+
+/**
+ * Registra um erro semântico, como um identificador não declarado.
+ * @param offset A posição do token onde o erro aparece.
+ * @param span O tamanho do token.
+ * @param message A mensagem, terminada em '\0'.
+ */
+void log_semantic_error(CompilerContext *context, uint32_t offset, uint32_t span, const char *message);
+
+/**
+ * Registra um erro semântico cuja posição já é conhecida, como em log_syntax_error_at.
+ */
+void log_semantic_error_at(CompilerContext *context, uint32_t offset, uint32_t span, int line, int column, const char *message);
+
+/**
+ * Registra que o scanner chegou ao fim do código-fonte, que termina em offset.
+ */
+void log_end_of_input(CompilerContext *context, uint32_t offset);
+
+/**
+ * Escreve os registros pendentes e encerra a thread de escrita.
+ * Também é chamada ao final da compilação, inclusive após um erro, e pode ser repetida.
+ */
+void log_cleanup(CompilerContext *context);
 
 #endif
\ No newline at end of file
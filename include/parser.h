@@ -1,68 +1,192 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include "token.h"
-
-void parser_init();
-
-void parser_parse();
-
-void parser_cleanup();
+#include <stdint.h>
+#include <stdbool.h>
 
-void parser_parse_constant();
-
-void parser_parse_variable();
-
-void parser_parse_multiplying_operator();
-
-void parser_parse_adding_operator();
+#include "ast.h"
+#include "token.h"
+#include "token_stream.h"
+#include "token_dump.h"
+#include "scope.h"
+
+#define PARSER_DEFAULT_MAX_ERRORS 100
+
+typedef struct CompilerContext CompilerContext;
+
+typedef enum
+{
+    PENDING_PARENTHESIS,
+    PENDING_UNARY,
+    PENDING_BINARY,
+} PendingKind;
+
+typedef struct
+{
+    uint8_t kind; // PendingKind
+    uint8_t precedence;
+    int8_t op;       // TokenKind
+    bool relational; // PENDING_PARENTHESIS: se a expressão de fora já tinha um operador relacional
+    uint32_t offset;
+} PendingOperator;
+
+/**
+ * Estado do parser de uma compilação.
+ */
+typedef struct
+{
+    TokenStream tokens; // Tokens do programa (ou o lote atual, na leitura em fluxo, ou o trecho da última reanálise)
+    uint32_t current;   // Índice do token atual em tokens
+
+    const TokenDump *replay; // Log binário reproduzido no lugar do scanner, ou NULL
+
+    Ast ast;       // Árvore sintática da compilação
+    AstIndex root; // Nó AST_PROGRAM construído por parser_parse
+
+    int error_count;             // Erros de sintaxe registrados
+    int max_errors;              // Limite de erros, de options.max_errors, ou 0 para nenhum limite
+    uint32_t first_error_offset; // Token do primeiro erro no código-fonte
+    uint32_t last_error_offset;  // Token do último erro no código-fonte
+    uint32_t recovery_offset;    // Token em que a última recuperação parou
+
+    uint32_t statement_offset; // Leitura em fluxo: início do comando em análise, cujas linhas o scanner mantém, ou UINT32_MAX
+
+    bool tentative;          // Reanálise incremental: o primeiro erro interrompe a análise sem ser registrado
+    TokenStream edit_tokens; // Memória reaproveitada para os tokens do trecho reanalisado por parser_reparse
+    uint32_t live_nodes;     // Nós da árvore; os outros da arena são subárvores substituídas por parser_reparse
+
+    ScopeStack scopes; // Declarações visíveis no ponto atual da análise, um escopo por bloco
+
+    PendingOperator *operators; // Operadores pendentes das expressões, reutilizados entre expressões
+    uint32_t operator_count;
+    uint32_t operator_capacity;
+
+    AstIndex *operands;
+    uint32_t operand_count;
+    uint32_t operand_capacity;
+} Parser;
+
+/**
+ * Prepara a análise do código-fonte do scanner. A memória dos tokens, do AST
+ * e das pilhas de uma compilação anterior no mesmo contexto é reutilizada.
+ */
+void parser_init(CompilerContext *context);
+
+/**
+ * Usa os tokens de um log binário em vez do scanner.
+ */
+void parser_init_replay(CompilerContext *context, const TokenDump *dump);
+
+/**
+ * Usa o resultado de uma análise guardada pelo cache de compilações no lugar
+ * de parser_init e parser_parse. Os nós já devem estar em parser->ast (ast_load).
+ */
+void parser_restore(CompilerContext *context, AstIndex root, int error_count, uint32_t first_error_offset, uint32_t last_error_offset, uint32_t recovery_offset);
+
+/**
+ * Analisa o programa, construindo a sua árvore sintática.
+ * @return O nó AST_PROGRAM.
+ */
+AstIndex parser_parse(CompilerContext *context);
+
+/**
+ * Atualiza a árvore sintática depois de scanner_edit, reanalisando só a
+ * declaração de subrotina (procedure ou function) mais interna que contém o
+ * trecho editado. As outras subárvores são mantidas, com os offsets seguintes
+ * deslocados; os nós substituídos continuam na arena até a próxima compilação.
+ *
+ * A reanálise é recusada quando a edição não está dentro de uma subrotina,
+ * muda tokens fora dela, muda o nome, o tipo ou a quantidade das declarações
+ * ou as deixa com erros, e quando a análise anterior tinha erros fora dela:
+ * nesses casos, o resultado de uma análise completa poderia ser diferente.
+ * Os escopos de fora são recriados a partir da árvore. Um erro durante a
+ * reanálise chama compiler_fail.
+ *
+ * As subárvores substituídas continuam na arena. Quando elas passam a ter
+ * mais nós que a árvore, a reanálise também é recusada, e a análise completa
+ * que a substitui libera a arena.
+ * @param offset O início do trecho editado.
+ * @param removed Quantos bytes foram removidos.
+ * @param inserted Quantos bytes foram inseridos no seu lugar.
+ * @return true se a árvore foi atualizada e o programa não tem erros.
+ */
+bool parser_reparse(CompilerContext *context, uint32_t offset, uint32_t removed, uint32_t inserted);
+
+/**
+ * Registra um erro semântico encontrado por um passo sobre a árvore, contado
+ * junto com os erros de sintaxe (max_errors, reanálise incremental).
+ * @param offset A posição do token onde o erro aparece.
+ * @param span O tamanho do token.
+ * @param message A mensagem, terminada em '\0'.
+ */
+void parser_semantic_error(CompilerContext *context, uint32_t offset, uint32_t span, const char *message);
+
+/**
+ * Como parser_semantic_error, com a linha e a coluna já calculadas, como as
+ * dos erros de tipo da leitura em fluxo ou as de um log reproduzido.
+ */
+void parser_semantic_error_at(CompilerContext *context, uint32_t offset, uint32_t span, int line, int column, const char *message);
 
-void parser_parse_sign();
+/**
+ * @return O nome de um símbolo dos nós AST_IDENTIFIER, na tabela de símbolos ou no log reproduzido.
+ */
+const char *parser_symbol_name(CompilerContext *context, uint32_t symbol);
 
-void parser_parse_relational_operator();
+/**
+ * @return A árvore sintática construída por parser_parse, válida até parser_cleanup.
+ */
+const Ast *parser_ast(const CompilerContext *context);
 
-void parser_parse_factor();
+/**
+ * @return Quantos erros de sintaxe e semânticos foram registrados por parser_parse.
+ */
+int parser_error_count(const CompilerContext *context);
 
-void parser_parse_term();
+void parser_cleanup(CompilerContext *context);
 
-void parser_parse_simple_expression();
+AstIndex parser_parse_variable(CompilerContext *context);
 
-void parser_parse_expression();
+AstIndex parser_parse_expression(CompilerContext *context);
 
-void parser_parse_while_statement();
+AstIndex parser_parse_while_statement(CompilerContext *context);
 
-void parser_parse_if_statement();
+AstIndex parser_parse_if_statement(CompilerContext *context);
 
-void parser_parse_read_write_statement();
+AstIndex parser_parse_read_write_statement(CompilerContext *context);
 
-void parser_parse_parameters_list();
+void parser_parse_parameters_list(CompilerContext *context, AstList *arguments);
 
-void parser_parse_function_procedure_statement();
+AstIndex parser_parse_function_procedure_statement(CompilerContext *context);
 
-void parser_parse_assignment_statement();
+AstIndex parser_parse_assignment_statement(CompilerContext *context);
 
-void parser_parse_statement();
+AstIndex parser_parse_statement(CompilerContext *context);
 
-void parser_parse_compound_statement();
+AstIndex parser_parse_compound_statement(CompilerContext *context);
 
-void parser_parse_formal_parameters();
+void parser_parse_formal_parameters(CompilerContext *context, AstList *parameters);
 
-void parser_parse_function_declaration();
+AstIndex parser_parse_function_declaration(CompilerContext *context);
 
-void parser_parse_procedure_declaration();
+AstIndex parser_parse_procedure_declaration(CompilerContext *context);
 
-void parser_parse_subroutine_declaration_part();
+void parser_parse_subroutine_declaration_part(CompilerContext *context, AstList *subroutines);
 
-void parser_parse_type();
+TokenKind parser_parse_type(CompilerContext *context);
 
-void parser_parse_variable_declaration();
+AstIndex parser_parse_variable_declaration(CompilerContext *context);
 
-void parser_parse_variable_declaration_part();
+void parser_parse_variable_declaration_part(CompilerContext *context, AstList *declarations);
 
-void parser_parse_block();
+/**
+ * Analisa um bloco no seu próprio escopo.
+ * @param parameters A primeira AST_VAR_DECLARATION dos parâmetros formais da subrotina,
+ *        declarados no escopo do bloco junto com as variáveis, ou AST_NONE.
+ */
+AstIndex parser_parse_block(CompilerContext *context, AstIndex parameters);
 
-void parser_parse_statement_part();
+AstIndex parser_parse_statement_part(CompilerContext *context);
 
-void parser_parse_program();
+AstIndex parser_parse_program(CompilerContext *context);
 
 #endif // PARSER_H
\ No newline at end of file
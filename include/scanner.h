@@ -2,27 +2,105 @@
 #define SCANNER_H
 
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
-#include "token.h" 
+#include "token.h"
+#include "token_stream.h"
+#include "lexer.h"
+#include "line_index.h"
 
-#define MAX_SYMBOLS 100
+typedef struct CompilerContext CompilerContext;
 
-extern Token symbol_table[MAX_SYMBOLS];
-extern int symbol_count;
+/**
+ * Estado do scanner de uma compilação. Os identificadores são internados em
+ * context->symbol_table: o campo symbol dos tokens TOKEN_IDENTIFIER é um ID dessa tabela.
+ */
+typedef struct
+{
+    char *source_buffer; // Código-fonte inteiro (mapeado com mmap ou lido para a memória), ou a janela de leitura
+    size_t source_size;  // Bytes em source_buffer
+    bool source_mapped;
+
+    int stream_fd;              // Descritor lido em fluxo, ou -1 se o código-fonte está inteiro na memória
+    uint32_t stream_base;       // Offset de source_buffer no código-fonte completo
+    bool stream_eof;            // O descritor já chegou ao fim
+    uint32_t stream_kept_lines; // As linhas a partir deste offset ficam no índice mesmo fora da janela
+    bool stream_comment_pending; // Um comentário longo saiu da janela e só é registrado ao terminar
+    int stream_comment_line;     // Linha e coluna do início desse comentário
+    int stream_comment_column;
+    char stream_comment_text[MAX_COMMENT_LENGTH]; // Início desse comentário, o que o log guarda dele
+
+    Lexer lexer;          // Lexer sequencial usado por get_token
+    LineIndex line_index; // Linhas calculadas sob demanda a partir dos offsets
+    int threads;
+} Scanner;
+
+/**
+ * Arquivos regulares são mapeados na memória. Pipes e terminais (ou "-",
+ * a entrada padrão) são lidos em fluxo por uma janela de tamanho fixo.
+ * @param source_filename Nome do arquivo do código-fonte, ou "-" para a entrada padrão
+ */
+void scanner_init(CompilerContext *context, const char source_filename[]);
+
+/**
+ * Usa um código-fonte que já está na memória, como o enviado a um servidor.
+ * @param source Memória alocada com malloc, que passa a pertencer ao scanner e é liberada em scanner_cleanup.
+ */
+void scanner_init_buffer(CompilerContext *context, char *source, size_t size);
+
+/**
+ * @return O próximo token do código-fonte, ou um token TOKEN_EOF ao final do arquivo
+ */
+Token get_token(CompilerContext *context);
+
+/**
+ * Define quantas threads scanner_tokenize_all pode usar em arquivos grandes.
+ */
+void scanner_set_threads(CompilerContext *context, int threads);
+
+/**
+ * Analisa todo o código-fonte de uma vez, adicionando os tokens ao fluxo.
+ * Arquivos grandes são divididos em trechos analisados em paralelo; o fluxo
+ * e o log resultantes são idênticos aos da análise sequencial com get_token.
+ * O último token adicionado é TOKEN_EOF.
+ */
+void scanner_tokenize_all(CompilerContext *context, TokenStream *stream);
+
+/**
+ * Substitui o conteúdo do fluxo pelos próximos tokens, terminados por TOKEN_EOF
+ * ao final do código-fonte. Um arquivo na memória é analisado de uma vez, como
+ * em scanner_tokenize_all. Na leitura em fluxo, o lote é limitado e o texto
+ * dos seus tokens permanece na janela de leitura até a próxima chamada.
+ * @param kept_lines Na leitura em fluxo, as linhas a partir deste offset continuam
+ *        no índice de linhas mesmo depois de sair da janela, ou UINT32_MAX.
+ */
+void scanner_next_tokens(CompilerContext *context, TokenStream *stream, uint32_t kept_lines);
+
+/**
+ * Substitui os removed bytes a partir de offset pelos inserted bytes de text,
+ * no código-fonte inteiro na memória de uma compilação terminada. Um arquivo
+ * mapeado passa a ser uma cópia em memória alocada com malloc.
+ */
+void scanner_edit(CompilerContext *context, uint32_t offset, uint32_t removed, const char *text, uint32_t inserted);
 
 /**
- * @param source_filename Nome do arquivo do código-fonte
+ * Analisa de novo o trecho [start, end) do código-fonte, sem registrar os
+ * tokens no log, e substitui o conteúdo do fluxo pelos seus tokens, sem TOKEN_EOF.
+ * @return false se houver um erro léxico no trecho ou se o último token ou
+ *         comentário passar de end, que então não é o início de um token.
  */
-void scanner_init(const char source_filename[]);
+bool scanner_relex(CompilerContext *context, uint32_t start, uint32_t end, TokenStream *stream);
 
 /**
- * @return O próximo token do código-fonte
+ * @return O texto do código-fonte que começa em offset, que deve estar na janela de leitura
  */
-Token *get_token();
+const char *scanner_text(CompilerContext *context, uint32_t offset);
 
 /**
  * Libera a memória usada pelo scanner
  */
-void scanner_cleanup();
+void scanner_cleanup(CompilerContext *context);
 
 #endif
\ No newline at end of file
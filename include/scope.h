@@ -0,0 +1,72 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arena.h"
+
+#define SCOPE_NONE UINT32_MAX
+#define SCOPE_INITIAL_SLOTS 16
+
+/**
+ * Declaração visível em um escopo.
+ */
+typedef struct
+{
+    uint32_t symbol;      // ID do nome (da tabela de símbolos, ou da string do log reproduzido)
+    uint32_t declaration; // Nó AST_IDENTIFIER do nome na declaração, nunca AST_NONE
+    uint8_t kind;         // AstKind da declaração: AST_VAR_DECLARATION, AST_PROCEDURE ou AST_FUNCTION
+    int8_t type;          // TokenKind do tipo da variável ou do resultado da função, ou TOKEN_KIND_NONE
+    uint16_t flags;       // Flags do nó da declaração (AST_FLAG_PARAMETER)
+} ScopeEntry;
+
+/**
+ * Pilha de escopos aninhados, um por bloco, da análise em andamento.
+ *
+ * Cada escopo é uma tabela com endereçamento aberto e sondagem linear,
+ * indexada pelo ID do símbolo, que dobra de tamanho quando fica 3/4 cheia.
+ * Os escopos ficam em sequência em uma arena: só o escopo mais interno
+ * recebe declarações, então ele sempre ocupa o fim da arena, e removê-lo é
+ * só voltar o fim da arena para o seu início.
+ */
+typedef struct
+{
+    Arena arena;
+    uint32_t top;   // Offset do escopo mais interno na arena, ou SCOPE_NONE
+    uint32_t depth; // Quantos escopos estão abertos
+} ScopeStack;
+
+void scope_stack_init(ScopeStack *scopes);
+
+/**
+ * Remove todos os escopos, mantendo a memória para reutilização.
+ */
+void scope_stack_reset(ScopeStack *scopes);
+
+/**
+ * Abre um escopo vazio dentro do escopo atual.
+ */
+void scope_push(ScopeStack *scopes);
+
+/**
+ * Fecha o escopo mais interno, descartando as suas declarações.
+ */
+void scope_pop(ScopeStack *scopes);
+
+/**
+ * Declara entry->symbol no escopo mais interno, que precisa existir.
+ * @return NULL, ou a declaração anterior do mesmo nome nesse escopo, que é mantida.
+ *         O ponteiro vale até a próxima chamada que altere a pilha.
+ */
+const ScopeEntry *scope_declare(ScopeStack *scopes, const ScopeEntry *entry);
+
+/**
+ * Procura symbol do escopo mais interno para o mais externo.
+ * @return A declaração visível, ou NULL. O ponteiro vale até a próxima chamada que altere a pilha.
+ */
+const ScopeEntry *scope_lookup(const ScopeStack *scopes, uint32_t symbol);
+
+void scope_stack_free(ScopeStack *scopes);
+
+#endif // SCOPE_H
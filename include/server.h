@@ -0,0 +1,51 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "compiler_context.h"
+
+#define SERVER_DEFAULT_MAX_SOURCE ((size_t)64 << 20) // 64 MiB
+
+/*
+Servidor de compilação em um socket Unix local.
+
+Cada conexão é atendida por uma thread própria e pode enviar vários pedidos,
+um de cada vez. Os contextos de compilação ficam em um conjunto compartilhado
+e são reutilizados entre pedidos e conexões, com a memória da tabela de
+símbolos, dos tokens e do AST já alocada. Uma conexão mantém o contexto da
+sua última compilação, que os pedidos edit atualizam, até ser fechada.
+Nenhum log de tokens é escrito.
+
+Pedidos, cada um em uma linha:
+    check <caminho>     Analisa o arquivo (caminhos relativos partem do diretório do servidor;
+                        "-" é recusado)
+    source <tamanho>    Analisa os <tamanho> bytes de código-fonte que seguem a linha
+    edit <offset> <removidos> <tamanho>
+                        Substitui <removidos> bytes a partir de <offset> no código-fonte
+                        do último check ou source da conexão pelos <tamanho> bytes que
+                        seguem a linha, e analisa de novo só a subrotina editada quando
+                        possível (compiler_edit)
+
+Respostas:
+    ok <tamanho>        O programa não tem erros
+    failed <tamanho>    O programa tem erros
+    error <tamanho>     O pedido é inválido
+seguidas de <tamanho> bytes com os diagnósticos, no mesmo formato da linha de
+comando, ou com a descrição do erro do pedido.
+
+Os bytes de source e edit são lidos aos poucos, e um pedido cujo código-fonte
+passaria de max_source bytes recebe error sem que eles sejam guardados.
+*/
+
+/**
+ * Escuta em socket_path até receber SIGINT ou SIGTERM. Um arquivo que já
+ * exista em socket_path é substituído, e é removido ao final.
+ * @param options As opções de cada compilação; sink, echo e output são ignorados.
+ * @param max_source O tamanho máximo do código-fonte de source e edit, como SERVER_DEFAULT_MAX_SOURCE.
+ * @return false se o socket não pôde ser criado.
+ */
+bool server_run(const char *socket_path, const CompilerOptions *options, size_t max_source);
+
+#endif // SERVER_H
@@ -0,0 +1,42 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Varreduras vetorizadas usadas pelo analisador léxico.
+
+Em x86-64 as funções usam SSE2 (sempre disponível) ou AVX2, escolhido em tempo
+de execução na primeira chamada. Nas demais arquiteturas é usada a versão escalar.
+*/
+
+/**
+ * Avança sobre espaços em branco (' ', '\t', '\n', '\v', '\f', '\r').
+ * @param start O primeiro caractere a ser examinado.
+ * @param end O fim do buffer.
+ * @return O primeiro caractere que não é espaço em branco, ou end.
+ */
+const char *simd_skip_whitespace(const char *start, const char *end);
+
+/**
+ * Procura o "*" + "/" que fecha um comentário.
+ * @param start O primeiro caractere após a abertura do comentário.
+ * @param end O fim do buffer.
+ * @return O '*' do fechamento, ou NULL se o comentário não for fechado.
+ */
+const char *simd_find_comment_end(const char *start, const char *end);
+
+/**
+ * @return O número de quebras de linha entre start e end.
+ */
+size_t simd_count_newlines(const char *start, const char *end);
+
+/**
+ * Grava a posição (relativa a start) de cada quebra de linha entre start e end.
+ * @param positions Deve ter espaço para simd_count_newlines(start, end) posições.
+ * @return O número de posições gravadas.
+ */
+size_t simd_collect_newlines(const char *start, const char *end, uint32_t *positions);
+
+#endif // SIMD_SCAN_H
@@ -0,0 +1,60 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYMBOL_NONE UINT32_MAX
+#define SYMBOL_TABLE_INITIAL_SLOTS 256
+#define SYMBOL_TABLE_INITIAL_NAMES 4096
+
+/**
+ * Tabela de internação de identificadores.
+ * Cada nome distinto é guardado uma única vez e recebe um ID estável de 32 bits,
+ * na ordem em que aparece pela primeira vez. A busca usa endereçamento aberto
+ * com sondagem linear e a tabela dobra de tamanho quando fica 3/4 cheia.
+ */
+typedef struct
+{
+    uint32_t *slots;      // ID + 1 do símbolo em cada posição (0 indica posição vazia)
+    uint32_t slot_count;  // Sempre uma potência de 2
+
+    uint32_t *hashes;     // Hash de cada símbolo, indexado pelo ID
+    uint32_t *offsets;    // Posição do nome de cada símbolo em names
+    uint32_t *lengths;    // Tamanho do nome de cada símbolo
+    uint32_t count;
+    uint32_t capacity;
+
+    char *names;          // Nomes concatenados, cada um terminado em '\0'
+    uint32_t names_size;
+    uint32_t names_capacity;
+} SymbolTable;
+
+void symbol_table_init(SymbolTable *table);
+
+/**
+ * Interna um nome, inserindo-o na tabela se ainda não existir.
+ * @param name O ponteiro para o início do nome (não precisa terminar em '\0').
+ * @param length O tamanho do nome.
+ * @return O ID do símbolo.
+ */
+uint32_t symbol_table_intern(SymbolTable *table, const char *name, size_t length);
+
+/**
+ * @return O ID do símbolo ou SYMBOL_NONE se o nome nunca foi internado.
+ */
+uint32_t symbol_table_find(const SymbolTable *table, const char *name, size_t length);
+
+/**
+ * @return O nome do símbolo, terminado em '\0'.
+ */
+const char *symbol_table_name(const SymbolTable *table, uint32_t symbol);
+
+/**
+ * Remove todos os símbolos, mantendo a memória já alocada para reutilização.
+ */
+void symbol_table_clear(SymbolTable *table);
+
+void symbol_table_free(SymbolTable *table);
+
+#endif // SYMBOL_TABLE_H
@@ -1,12 +1,71 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#define MAX_TOKEN_LENGTH 50
+#include <stdint.h>
+
 #define MAX_COMMENT_LENGTH 250
 
+/**
+ * Lexema específico de cada palavra reservada, operador e delimitador,
+ * ao lado do TokenType da sua categoria. Um mesmo lexema tem sempre o mesmo
+ * TokenKind, qualquer que seja a lista de src/token.c em que aparece.
+ */
+typedef enum
+{
+    TOKEN_KIND_NONE = -1, // Identificadores, números, comentários e EOF
+
+    KW_PROGRAM,
+    KW_BEGIN,
+    KW_END,
+    KW_PROCEDURE,
+    KW_FUNCTION,
+    KW_IF,
+    KW_THEN,
+    KW_ELSE,
+    KW_WHILE,
+    KW_DO,
+    KW_VAR,
+    KW_INTEGER,
+    KW_BOOLEAN,
+    KW_WRITE,
+
+    BOOL_TRUE,
+    BOOL_FALSE,
+
+    OP_PLUS,  // +
+    OP_MINUS, // -
+    OP_TIMES, // *
+    OP_DIV,   // div
+
+    REL_EQ, // =
+    REL_NE, // <>
+    REL_LT, // <
+    REL_LE, // <=
+    REL_GT, // >
+    REL_GE, // >=
+
+    OP_AND,
+    OP_OR,
+    OP_NOT,
+
+    OP_ASSIGN, // :=
+
+    DELIM_LPAREN, // (
+    DELIM_RPAREN, // )
+    DELIM_COMMA,  // ,
+    DELIM_COLON,  // :
+    DELIM_DOT,    // .
+    DELIM_SEMI,   // ;
+
+    TOKEN_KIND_COUNT
+} TokenKind;
+
 extern const char *keywords[];
 extern const int num_keywords;
 
+extern const char *booleans[];
+extern const int num_booleans;
+
 extern const char *arithmetic_operators[];
 extern const int num_arithmetic_operators;
 
@@ -19,6 +78,14 @@ extern const int num_logical_operators;
 extern const char *delimiters[];
 extern const int num_delimiters;
 
+// TokenKind de cada lexema das listas acima, na mesma ordem
+extern const TokenKind keyword_kinds[];
+extern const TokenKind boolean_kinds[];
+extern const TokenKind arithmetic_operator_kinds[];
+extern const TokenKind relational_operator_kinds[];
+extern const TokenKind logical_operator_kinds[];
+extern const TokenKind delimiter_kinds[];
+
 typedef enum
 {
     TOKEN_LETTER,
@@ -33,13 +100,21 @@ typedef enum
     TOKEN_OPERATOR_ASSIGNMENT,
     TOKEN_DELIMITER,
     TOKEN_COMMENT,
+    TOKEN_EOF,
 } TokenType;
 
+/**
+ * Token representado como um intervalo do código-fonte, sem alocação dinâmica.
+ * O lexema é lido diretamente do buffer do código-fonte quando necessário, e a
+ * linha e a coluna são calculadas a partir do offset (line_index.h).
+ */
 typedef struct
 {
     TokenType type;
-    char *value;
-    int line;
+    TokenKind kind;  // Lexema específico, ou TOKEN_KIND_NONE
+    uint32_t offset; // Posição do primeiro caractere do lexema no código-fonte
+    uint32_t length; // Tamanho do lexema em bytes
+    uint32_t symbol; // ID internado do identificador, ou SYMBOL_NONE
 } Token;
 
 /**
@@ -47,14 +122,19 @@ typedef struct
  */
 const char *token_type_to_string(TokenType type);
 
+/**
+ * Converte o TokenKind para o nome da constante (por exemplo, "KW_BEGIN").
+ */
+const char *token_kind_to_string(TokenKind kind);
+
 /**
  * Cria um novo token.
  * @param type O tipo do token.
- * @param start O ponteiro para o início do valor do token na fonte.
- * @param end O ponteiro para o fim do valor do token na fonte.
- * @param line O número da linha onde o token foi encontrado.
- * @return Um ponteiro para o token criado.
+ * @param kind O lexema específico, ou TOKEN_KIND_NONE.
+ * @param offset A posição do início do lexema no código-fonte.
+ * @param length O tamanho do lexema.
+ * @return O token criado.
  */
-Token *create_token(TokenType type, const char *start, const char *end, int line);
+Token create_token(TokenType type, TokenKind kind, uint32_t offset, uint32_t length);
 
 #endif // TOKEN_H
\ No newline at end of file
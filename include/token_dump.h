@@ -0,0 +1,92 @@
+#ifndef TOKEN_DUMP_H
+#define TOKEN_DUMP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "token_stream.h"
+
+/*
+Formato binário do log de tokens (<program>.tokens.bin), pensado para ser
+mapeado com mmap e lido sem conversão. Todos os inteiros estão na ordem de
+bytes da máquina que o gerou.
+
+    TokenDumpHeader
+    TokenDumpRecord[record_count]   Tokens e comentários, na ordem do código-fonte
+    uint32_t[string_count]          Offset de cada string em names
+    uint32_t[string_count]          Tamanho de cada string
+    char[names_size]                Strings concatenadas, cada uma terminada em '\0'
+
+O texto de cada token é internado: tokens iguais apontam para a mesma string.
+O último registro de um log completo é TOKEN_EOF.
+*/
+
+#define TOKEN_DUMP_MAGIC "MPTK"
+#define TOKEN_DUMP_VERSION 3
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t string_count;
+    uint64_t records_offset;
+    uint64_t strings_offset;
+    uint64_t names_size;
+} TokenDumpHeader;
+
+typedef struct
+{
+    uint8_t type; // TokenType
+    uint8_t reserved;
+    int16_t kind;
+    uint32_t offset;
+    uint32_t length; // Tamanho do token no código-fonte
+    uint32_t line;
+    uint32_t column;
+    uint32_t string; // Texto do token (comentários são limitados a MAX_COMMENT_LENGTH - 1 caracteres)
+} TokenDumpRecord;
+
+/**
+ * Um log binário mapeado na memória.
+ */
+typedef struct
+{
+    const char *data;
+    size_t size;
+
+    const TokenDumpRecord *records;
+    uint32_t record_count;
+
+    const uint32_t *string_offsets;
+    const uint32_t *string_lengths;
+    uint32_t string_count;
+    const char *names;
+} TokenDump;
+
+/**
+ * Mapeia e valida um log binário.
+ * @return false, com o erro já registrado, se o arquivo não puder ser lido ou for inválido ou incompleto.
+ */
+bool token_dump_open(TokenDump *dump, const char *filename);
+
+/**
+ * Adiciona os tokens do log ao fluxo, sem os comentários. O campo symbol de
+ * cada token recebe o ID da string com o seu texto.
+ */
+void token_dump_load(const TokenDump *dump, TokenStream *stream);
+
+/**
+ * @return O registro do token que começa em offset, ou NULL se não houver.
+ */
+const TokenDumpRecord *token_dump_find(const TokenDump *dump, uint32_t offset);
+
+/**
+ * @return A string, terminada em '\0'.
+ */
+const char *token_dump_string(const TokenDump *dump, uint32_t string);
+
+void token_dump_close(TokenDump *dump);
+
+#endif // TOKEN_DUMP_H
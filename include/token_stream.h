@@ -0,0 +1,47 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <stdint.h>
+
+#include "token.h"
+
+#define TOKEN_STREAM_INITIAL_CAPACITY 1024
+
+/**
+ * Sequência de tokens em vetores paralelos (structure of arrays).
+ * O último token de um fluxo completo é sempre TOKEN_EOF.
+ */
+typedef struct
+{
+    uint8_t *types;
+    int16_t *kinds;
+    uint32_t *offsets;
+    uint32_t *lengths;
+    uint32_t *symbols;
+    uint32_t count;
+    uint32_t capacity;
+} TokenStream;
+
+void token_stream_init(TokenStream *stream);
+
+/**
+ * Adiciona um token ao final do fluxo.
+ */
+void token_stream_push(TokenStream *stream, const Token *token);
+
+/**
+ * Reconstrói o token na posição index, por exemplo para diagnósticos.
+ */
+Token token_stream_get(const TokenStream *stream, uint32_t index);
+
+/**
+ * Remove todos os tokens, mantendo a memória já alocada para reutilização.
+ */
+static inline void token_stream_clear(TokenStream *stream)
+{
+    stream->count = 0;
+}
+
+void token_stream_free(TokenStream *stream);
+
+#endif // TOKEN_STREAM_H
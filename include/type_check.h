@@ -0,0 +1,144 @@
+#ifndef TYPE_CHECK_H
+#define TYPE_CHECK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ast.h"
+
+/*
+Verificação de tipos.
+
+Cada nó é criado depois dos seus filhos, então a arena da árvore já está em
+pós-ordem: um único laço pelos índices calcula o tipo de cada nó a partir dos
+tipos dos filhos, já calculados, sem recursão nem pilha. Os tipos ficam em uma
+tabela de um byte por nó, indexada pelo AstIndex, que os passos seguintes
+consultam com type_of em vez de recalcular.
+
+Os usos de identificadores já chegam resolvidos pelo parser, com o tipo da
+declaração em op (AST_FLAG_VARIABLE e AST_FLAG_SUBROUTINE).
+
+Os erros do parser são registrados na ordem do código-fonte, durante a análise.
+Os erros de tipo só são registrados quando ela termina sem erros, para não
+aparecerem depois de erros de linhas seguintes; a tabela é preenchida de
+qualquer forma.
+
+Na leitura em fluxo, o índice de linhas só cobre a janela de leitura. Os nós
+são verificados a cada lote de tokens (type_check_pending), antes que as
+linhas dos seus tokens saiam do índice, e os erros ficam guardados com a
+linha e a coluna até o fim da análise (type_check_finish). O if e o while de
+um comando longo são criados depois que a linha da palavra-chave saiu do
+índice, e o parser guarda antes a sua posição (type_position_at).
+*/
+
+typedef enum
+{
+    TYPE_NONE,    // Comandos, declarações e nomes de procedure: o nó não tem valor
+    TYPE_INTEGER,
+    TYPE_BOOLEAN,
+    TYPE_ERROR,   // Expressão com um erro já registrado, que não gera outros erros
+} Type;
+
+/**
+ * Linha e coluna do token de um nó, calculadas na leitura em fluxo enquanto a
+ * linha está no índice.
+ */
+typedef struct
+{
+    AstIndex node;
+    int line; // 0 fora da leitura em fluxo, em que a posição não é guardada
+    int column;
+} TypePosition;
+
+/**
+ * Erro de tipo encontrado por type_check_pending, registrado por type_check_finish.
+ */
+typedef struct
+{
+    uint32_t offset;
+    uint32_t span;
+    int line;
+    int column;
+    char *message;
+} TypeDiagnostic;
+
+/**
+ * Tipo de cada nó da árvore de uma compilação.
+ */
+typedef struct
+{
+    uint8_t *types; // Type de cada nó
+    uint32_t count; // Nós com tipo calculado
+    uint32_t capacity;
+
+    TypeDiagnostic *diagnostics; // Erros da leitura em fluxo, ainda não registrados
+    uint32_t diagnostic_count;
+    uint32_t diagnostic_capacity;
+
+    TypePosition *positions; // Posições guardadas por type_position_keep, em ordem de nó
+    uint32_t position_count;
+    uint32_t position_capacity;
+} TypeTable;
+
+typedef struct CompilerContext CompilerContext;
+
+/**
+ * Calcula o tipo dos nós de first até o último nó da árvore e verifica os
+ * operandos dos operadores, as condições de if e while, as atribuições e os
+ * valores escritos por write.
+ * @param first AST_NONE + 1 para a árvore inteira, ou o primeiro nó criado por parser_reparse.
+ * @param report Se os erros são registrados com parser_semantic_error. Sem registro, só a
+ *        tabela é preenchida, como depois de um acerto do cache, cujos erros já foram reproduzidos.
+ * @return Quantos erros de tipo foram encontrados.
+ */
+uint32_t type_check(CompilerContext *context, AstIndex first, bool report);
+
+/**
+ * Na leitura em fluxo, calcula o tipo dos nós criados desde a última chamada,
+ * antes que o próximo lote de tokens descarte linhas do índice. Os erros são
+ * guardados com a linha e a coluna.
+ */
+void type_check_pending(CompilerContext *context);
+
+/**
+ * Termina a verificação de uma leitura em fluxo: verifica os nós restantes e
+ * registra os erros guardados com parser_semantic_error_at.
+ * @param report Se os erros são registrados; sem registro, só são descartados.
+ * @return Quantos erros de tipo foram encontrados.
+ */
+uint32_t type_check_finish(CompilerContext *context, bool report);
+
+/**
+ * Na leitura em fluxo, calcula a linha e a coluna de offset, que ainda estão
+ * no índice, para um nó que só será criado depois.
+ * @return A posição para type_position_keep.
+ */
+TypePosition type_position_at(CompilerContext *context, uint32_t offset);
+
+/**
+ * Usa position para os erros de tipo de node, o último nó criado. Fora da
+ * leitura em fluxo, nada é guardado.
+ */
+void type_position_keep(CompilerContext *context, AstIndex node, TypePosition position);
+
+/**
+ * @return O tipo calculado por type_check para o nó.
+ */
+static inline Type type_of(const TypeTable *table, AstIndex node)
+{
+    return node < table->count ? (Type)table->types[node] : TYPE_NONE;
+}
+
+/**
+ * @return "integer", "boolean" ou uma descrição dos outros tipos, para as mensagens de erro.
+ */
+const char *type_to_string(Type type);
+
+/**
+ * Esvazia a tabela para a próxima compilação, descartando os erros guardados.
+ */
+void type_table_clear(TypeTable *table);
+
+void type_table_free(TypeTable *table);
+
+#endif // TYPE_CHECK_H
@@ -0,0 +1,17 @@
+#include "allocation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void *checked_realloc(void *pointer, size_t size, const char *message)
+{
+    void *result = realloc(pointer, size);
+
+    if (result == NULL)
+    {
+        perror(message);
+        exit(EXIT_FAILURE);
+    }
+
+    return result;
+}
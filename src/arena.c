@@ -0,0 +1,72 @@
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void arena_grow(Arena *arena, uint64_t required)
+{
+    uint64_t capacity = arena->capacity ? arena->capacity : ARENA_INITIAL_CAPACITY;
+
+    while (capacity < required)
+    {
+        capacity *= 2;
+    }
+
+    // Os offsets têm 32 bits
+    if (capacity > UINT32_MAX)
+    {
+        capacity = UINT32_MAX;
+    }
+
+    char *data = capacity < required ? NULL : (char *)realloc(arena->data, capacity);
+
+    if (data == NULL)
+    {
+        perror("Error allocating arena");
+        exit(EXIT_FAILURE);
+    }
+
+    arena->data = data;
+    arena->capacity = capacity;
+}
+
+void arena_init(Arena *arena)
+{
+    memset(arena, 0, sizeof(*arena));
+}
+
+uint32_t arena_alloc(Arena *arena, size_t size)
+{
+    uint64_t offset = ((uint64_t)arena->size + ARENA_ALIGNMENT - 1) & ~(uint64_t)(ARENA_ALIGNMENT - 1);
+    uint64_t end = offset + size;
+
+    if (end > arena->capacity)
+    {
+        arena_grow(arena, end);
+    }
+
+    memset(arena->data + offset, 0, size);
+    arena->size = end;
+
+    return offset;
+}
+
+void arena_rewind(Arena *arena, uint32_t offset)
+{
+    if (offset < arena->size)
+    {
+        arena->size = offset;
+    }
+}
+
+void arena_reset(Arena *arena)
+{
+    arena->size = 0;
+}
+
+void arena_free(Arena *arena)
+{
+    free(arena->data);
+    memset(arena, 0, sizeof(*arena));
+}
@@ -0,0 +1,96 @@
+#include "ast.h"
+
+#include <string.h>
+
+void ast_init(Ast *ast)
+{
+    arena_init(&ast->arena);
+
+    // Reserva o nó AST_NONE, para que o índice 0 nunca seja um nó válido
+    arena_alloc(&ast->arena, sizeof(AstNode));
+    ast->count = 1;
+}
+
+void ast_reset(Ast *ast)
+{
+    arena_reset(&ast->arena);
+
+    arena_alloc(&ast->arena, sizeof(AstNode));
+    ast->count = 1;
+}
+
+void ast_load(Ast *ast, const void *nodes, uint32_t count)
+{
+    arena_reset(&ast->arena);
+
+    uint32_t offset = arena_alloc(&ast->arena, (size_t)count * sizeof(AstNode));
+    memcpy(arena_at(&ast->arena, offset), nodes, (size_t)count * sizeof(AstNode));
+    ast->count = count;
+}
+
+AstIndex ast_add(Ast *ast, AstKind kind, TokenKind op, uint32_t offset)
+{
+    // A arena só contém nós, então o offset de cada um é múltiplo de sizeof(AstNode)
+    AstIndex index = arena_alloc(&ast->arena, sizeof(AstNode)) / sizeof(AstNode);
+    AstNode *node = ast_node(ast, index);
+
+    node->kind = kind;
+    node->op = op;
+    node->offset = offset;
+    ast->count++;
+
+    return index;
+}
+
+void ast_list_append(const Ast *ast, AstList *list, AstIndex node)
+{
+    if (list->first == AST_NONE)
+    {
+        list->first = node;
+    }
+    else
+    {
+        ast_node(ast, list->last)->next = node;
+    }
+
+    list->last = node;
+}
+
+AstIndex ast_add_list(Ast *ast, AstKind kind, TokenKind op, uint32_t offset, const AstList *children)
+{
+    AstIndex index = ast_add(ast, kind, op, offset);
+    ast_node(ast, index)->first = children->first;
+    return index;
+}
+
+const char *ast_kind_to_string(AstKind kind)
+{
+    static const char *const names[] = {
+        [AST_EMPTY] = "EMPTY",
+        [AST_PROGRAM] = "PROGRAM",
+        [AST_BLOCK] = "BLOCK",
+        [AST_VAR_DECLARATION] = "VAR_DECLARATION",
+        [AST_PROCEDURE] = "PROCEDURE",
+        [AST_FUNCTION] = "FUNCTION",
+        [AST_COMPOUND] = "COMPOUND",
+        [AST_ASSIGNMENT] = "ASSIGNMENT",
+        [AST_CALL] = "CALL",
+        [AST_IF] = "IF",
+        [AST_WHILE] = "WHILE",
+        [AST_WRITE] = "WRITE",
+        [AST_BINARY] = "BINARY",
+        [AST_UNARY] = "UNARY",
+        [AST_IDENTIFIER] = "IDENTIFIER",
+        [AST_NUMBER] = "NUMBER",
+        [AST_BOOLEAN] = "BOOLEAN",
+        [AST_ERROR] = "ERROR",
+    };
+
+    return names[kind];
+}
+
+void ast_free(Ast *ast)
+{
+    arena_free(&ast->arena);
+    ast->count = 0;
+}
@@ -0,0 +1,402 @@
+#include "batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "allocation.h"
+
+typedef struct
+{
+    const char *filename;
+    off_t size;     // Tamanho do arquivo, usado para começar pelos maiores
+    int open_error; // errno de stat, ou 0
+
+    char *diagnostics; // Saída da compilação, escrita só depois dos arquivos anteriores
+    size_t diagnostics_size;
+    bool success;
+    double milliseconds;
+    uint32_t folded; // Nós removidos por constant_fold
+    bool done; // Protegido por Batch.lock
+} BatchJob;
+
+/**
+ * Fila de arquivos de uma thread, do maior para o menor. A dona tira do
+ * início; as outras threads roubam do fim, onde estão os menores.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    int *items; // Índices em Batch.jobs
+    int head;
+    int tail;
+} WorkQueue;
+
+typedef struct
+{
+    BatchJob *jobs;
+    int job_count;
+
+    WorkQueue *queues;
+    int worker_count;
+
+    const CompilerOptions *options;
+    bool replay;
+
+    pthread_mutex_t lock;     // Protege BatchJob.done
+    pthread_cond_t completed; // Sinalizado a cada arquivo concluído
+} Batch;
+
+typedef struct
+{
+    Batch *batch;
+    int index;
+} Worker;
+
+void batch_inputs_init(BatchInputs *inputs)
+{
+    memset(inputs, 0, sizeof(*inputs));
+}
+
+void batch_inputs_add(BatchInputs *inputs, const char *filename)
+{
+    if (inputs->count == inputs->capacity)
+    {
+        inputs->capacity = inputs->capacity ? inputs->capacity * 2 : 64;
+        inputs->files = (char **)checked_realloc(inputs->files, inputs->capacity * sizeof(char *), "Error allocating batch");
+    }
+
+    size_t length = strlen(filename) + 1;
+    char *copy = (char *)checked_realloc(NULL, length, "Error allocating batch");
+
+    memcpy(copy, filename, length);
+    inputs->files[inputs->count++] = copy;
+}
+
+bool batch_inputs_add_response_file(BatchInputs *inputs, const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL)
+    {
+        perror("Error opening response file");
+        return false;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+
+    while ((length = getline(&line, &capacity, file)) >= 0)
+    {
+        // Remove a quebra de linha e os espaços do fim
+        while (length > 0 && isspace((unsigned char)line[length - 1]))
+        {
+            line[--length] = '\0';
+        }
+
+        if (length > 0 && line[0] != '#')
+        {
+            batch_inputs_add(inputs, line);
+        }
+    }
+
+    free(line);
+    fclose(file);
+
+    return true;
+}
+
+void batch_inputs_free(BatchInputs *inputs)
+{
+    for (int i = 0; i < inputs->count; i++)
+    {
+        free(inputs->files[i]);
+    }
+
+    free(inputs->files);
+    memset(inputs, 0, sizeof(*inputs));
+}
+
+static double elapsed_milliseconds(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/* Filas */
+
+/**
+ * @return O próximo arquivo da fila da thread, ou -1 se ela estiver vazia.
+ */
+static int queue_pop(WorkQueue *queue)
+{
+    int job = -1;
+
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->head < queue->tail)
+    {
+        job = queue->items[queue->head++];
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+/**
+ * @return O último (menor) arquivo da fila de outra thread, ou -1 se ela estiver vazia.
+ */
+static int queue_steal(WorkQueue *queue)
+{
+    int job = -1;
+
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->head < queue->tail)
+    {
+        job = queue->items[--queue->tail];
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+/**
+ * @return O próximo arquivo da thread worker, roubado de outra fila se a sua
+ *         estiver vazia, ou -1 se não houver mais arquivos. Nenhum arquivo é
+ *         adicionado depois do início, então filas vazias continuam vazias.
+ */
+static int batch_next(Batch *batch, int worker)
+{
+    int job = queue_pop(&batch->queues[worker]);
+
+    for (int i = 1; job < 0 && i < batch->worker_count; i++)
+    {
+        job = queue_steal(&batch->queues[(worker + i) % batch->worker_count]);
+    }
+
+    return job;
+}
+
+/* Compilação */
+
+static void batch_run(Batch *batch, CompilerContext *context, BatchJob *job)
+{
+    struct timespec start, end;
+    FILE *output = open_memstream(&job->diagnostics, &job->diagnostics_size);
+
+    if (output == NULL)
+    {
+        perror("Error allocating diagnostics");
+        exit(EXIT_FAILURE);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (job->open_error != 0)
+    {
+        fprintf(output, "Error opening source file: %s\n", strerror(job->open_error));
+        job->success = false;
+    }
+    else
+    {
+        context->options = *batch->options;
+        context->options.output = output;
+        context->options.log_name = job->filename;
+
+        job->success = batch->replay ? compiler_replay(context, job->filename) : compiler_compile(context, job->filename);
+        job->folded = context->folded;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fclose(output);
+
+    job->milliseconds = elapsed_milliseconds(&start, &end);
+
+    pthread_mutex_lock(&batch->lock);
+    job->done = true;
+    pthread_cond_broadcast(&batch->completed);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+static void *batch_worker(void *argument)
+{
+    Worker *worker = (Worker *)argument;
+    Batch *batch = worker->batch;
+    CompilerContext context;
+    int job;
+
+    // O contexto (e a memória da tabela de símbolos, do AST e dos tokens) é reaproveitado entre os arquivos
+    compiler_context_init(&context);
+
+    while ((job = batch_next(batch, worker->index)) >= 0)
+    {
+        batch_run(batch, &context, &batch->jobs[job]);
+    }
+
+    compiler_context_free(&context);
+    return NULL;
+}
+
+typedef struct
+{
+    off_t size;
+    int job;
+} JobOrder;
+
+/**
+ * Ordem de distribuição: do maior para o menor arquivo, e na ordem da entrada entre arquivos do mesmo tamanho.
+ */
+static int compare_jobs(const void *a, const void *b)
+{
+    const JobOrder *first = (const JobOrder *)a;
+    const JobOrder *second = (const JobOrder *)b;
+
+    if (first->size != second->size)
+    {
+        return first->size > second->size ? -1 : 1;
+    }
+
+    return first->job - second->job;
+}
+
+bool batch_compile(const BatchInputs *inputs, const CompilerOptions *options, int workers, bool replay)
+{
+    Batch batch;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    batch.job_count = inputs->count;
+    batch.jobs = (BatchJob *)checked_realloc(NULL, (inputs->count + 1) * sizeof(BatchJob), "Error allocating batch");
+    batch.worker_count = workers < inputs->count ? workers : inputs->count;
+    batch.worker_count = batch.worker_count < 1 ? 1 : batch.worker_count;
+    batch.options = options;
+    batch.replay = replay;
+    pthread_mutex_init(&batch.lock, NULL);
+    pthread_cond_init(&batch.completed, NULL);
+
+    JobOrder *order = (JobOrder *)checked_realloc(NULL, (inputs->count + 1) * sizeof(JobOrder), "Error allocating batch");
+
+    for (int i = 0; i < inputs->count; i++)
+    {
+        BatchJob *job = &batch.jobs[i];
+        struct stat info;
+
+        memset(job, 0, sizeof(*job));
+        job->filename = inputs->files[i];
+
+        // A entrada padrão não tem tamanho conhecido
+        if (strcmp(job->filename, "-") != 0)
+        {
+            if (stat(job->filename, &info) == 0)
+            {
+                job->size = info.st_size;
+            }
+            else
+            {
+                job->open_error = errno;
+            }
+        }
+
+        order[i] = (JobOrder){job->size, i};
+    }
+
+    qsort(order, inputs->count, sizeof(JobOrder), compare_jobs);
+
+    // Cada fila recebe um arquivo de cada vez, então todas começam pelos maiores
+    batch.queues = (WorkQueue *)checked_realloc(NULL, batch.worker_count * sizeof(WorkQueue), "Error allocating batch");
+
+    for (int w = 0; w < batch.worker_count; w++)
+    {
+        WorkQueue *queue = &batch.queues[w];
+
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->items = (int *)checked_realloc(NULL, (inputs->count / batch.worker_count + 1) * sizeof(int), "Error allocating batch");
+        queue->head = queue->tail = 0;
+    }
+
+    for (int i = 0; i < inputs->count; i++)
+    {
+        WorkQueue *queue = &batch.queues[i % batch.worker_count];
+        queue->items[queue->tail++] = order[i].job;
+    }
+
+    free(order);
+
+    pthread_t *threads = (pthread_t *)checked_realloc(NULL, batch.worker_count * sizeof(pthread_t), "Error allocating batch");
+    Worker *worker_arguments = (Worker *)checked_realloc(NULL, batch.worker_count * sizeof(Worker), "Error allocating batch");
+
+    for (int w = 0; w < batch.worker_count; w++)
+    {
+        worker_arguments[w] = (Worker){&batch, w};
+
+        if (pthread_create(&threads[w], NULL, batch_worker, &worker_arguments[w]) != 0)
+        {
+            perror("Error starting batch worker");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Os diagnósticos são escritos na ordem da entrada, assim que cada arquivo e os anteriores terminam
+    FILE *output = options->output;
+    int failed = 0;
+
+    for (int i = 0; i < inputs->count; i++)
+    {
+        BatchJob *job = &batch.jobs[i];
+
+        pthread_mutex_lock(&batch.lock);
+
+        while (!job->done)
+        {
+            pthread_cond_wait(&batch.completed, &batch.lock);
+        }
+
+        pthread_mutex_unlock(&batch.lock);
+
+        fwrite(job->diagnostics, 1, job->diagnostics_size, output);
+        if (options->fold && job->success)
+        {
+            fprintf(output, "%s: ok (%.3f ms, %u nodes folded)\n", job->filename, job->milliseconds, job->folded);
+        }
+        else
+        {
+            fprintf(output, "%s: %s (%.3f ms)\n", job->filename, job->success ? "ok" : "failed", job->milliseconds);
+        }
+        fflush(output);
+
+        free(job->diagnostics);
+        failed += !job->success;
+    }
+
+    // As threads que terminam primeiro ainda podem estar tentando roubar das filas das outras
+    for (int w = 0; w < batch.worker_count; w++)
+    {
+        pthread_join(threads[w], NULL);
+    }
+
+    for (int w = 0; w < batch.worker_count; w++)
+    {
+        pthread_mutex_destroy(&batch.queues[w].lock);
+        free(batch.queues[w].items);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fprintf(output, "%d files, %d failed, %.3f ms on %d threads\n", inputs->count, failed, elapsed_milliseconds(&start, &end), batch.worker_count);
+    fflush(output);
+
+    pthread_cond_destroy(&batch.completed);
+    pthread_mutex_destroy(&batch.lock);
+    free(worker_arguments);
+    free(threads);
+    free(batch.queues);
+    free(batch.jobs);
+
+    return failed == 0;
+}
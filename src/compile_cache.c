@@ -0,0 +1,665 @@
+#include "compile_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "compiler_context.h"
+
+#define CACHE_MAGIC 0x4343504d // "MPCC"
+#define CACHE_FORMAT_VERSION 2
+#define CACHE_EXTENSION ".entry"
+#define CACHE_TEMPORARY_EXTENSION ".tmp"
+#define CACHE_TEMPORARY_MAX_AGE 3600 // Segundos até um temporário abandonado (processo interrompido) ser removido
+
+// Cada build do compilador invalida as entradas, porque a saída pode ter mudado
+static const char compiler_version[] = __DATE__ " " __TIME__;
+
+/**
+ * Cabeçalho de uma entrada, seguido da saída, do log de tokens, dos nós da
+ * árvore (a partir do nó 0 reservado) e dos nomes dos símbolos, cada um
+ * terminado em '\0', na ordem dos IDs.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key[2];
+    uint64_t source_size;
+    uint64_t output_size;
+    uint64_t log_size;
+    uint32_t node_count;
+    uint32_t root;
+    uint32_t symbol_count;
+    uint32_t names_size;
+    int32_t error_count;
+    uint32_t first_error_offset;
+    uint32_t last_error_offset;
+    uint32_t recovery_offset;
+} CacheHeader;
+
+typedef struct
+{
+    char *name;
+    struct timespec used; // Data de modificação, atualizada a cada acerto
+    off_t size;
+} CacheFile;
+
+/* Hash */
+
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t rotate_left(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const char *data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const char *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint64_t hash_round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * PRIME64_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+static inline uint64_t hash_merge(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= hash_round(0, accumulator);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+/**
+ * Hash de 64 bits no formato do XXH64: quatro acumuladores independentes
+ * consomem 32 bytes por iteração, e o final passa por uma avalanche.
+ */
+static uint64_t hash_bytes(const char *data, size_t size, uint64_t seed)
+{
+    const char *end = data + size;
+    uint64_t hash;
+
+    if (size >= 32)
+    {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+
+        for (; data + 32 <= end; data += 32)
+        {
+            v1 = hash_round(v1, read64(data));
+            v2 = hash_round(v2, read64(data + 8));
+            v3 = hash_round(v3, read64(data + 16));
+            v4 = hash_round(v4, read64(data + 24));
+        }
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = hash_merge(hash, v1);
+        hash = hash_merge(hash, v2);
+        hash = hash_merge(hash, v3);
+        hash = hash_merge(hash, v4);
+    }
+    else
+    {
+        hash = seed + PRIME64_5;
+    }
+
+    hash += size;
+
+    for (; data + 8 <= end; data += 8)
+    {
+        hash ^= hash_round(0, read64(data));
+        hash = rotate_left(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+
+    if (data + 4 <= end)
+    {
+        hash ^= read32(data) * PRIME64_1;
+        hash = rotate_left(hash, 23) * PRIME64_2 + PRIME64_3;
+        data += 4;
+    }
+
+    for (; data < end; data++)
+    {
+        hash ^= (uint8_t)*data * PRIME64_5;
+        hash = rotate_left(hash, 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/**
+ * Chave de 128 bits do código-fonte do scanner, da versão do compilador e das opções que mudam a saída.
+ */
+static void cache_key(const CompilerContext *context, uint64_t key[2])
+{
+    const CompilerOptions *options = &context->options;
+    const Scanner *scanner = &context->scanner;
+    char settings[256];
+
+    int length = snprintf(settings, sizeof(settings), "%d %s %s %d %d", CACHE_FORMAT_VERSION, compiler_version, options->sink->name, options->echo && options->sink->echo, options->max_errors);
+    uint64_t seed = hash_bytes(settings, length, 0);
+
+    key[0] = hash_bytes(scanner->source_buffer, scanner->source_size, seed);
+    key[1] = hash_bytes(scanner->source_buffer, scanner->source_size, seed ^ PRIME64_3);
+}
+
+/* Arquivos */
+
+static bool ends_with(const char *name, const char *suffix)
+{
+    size_t length = strlen(name), suffix_length = strlen(suffix);
+
+    return length > suffix_length && strcmp(name + length - suffix_length, suffix) == 0;
+}
+
+/**
+ * @return false se o caminho não couber em path.
+ */
+static bool entry_path(const CompileCache *cache, const uint64_t key[2], char path[PATH_MAX])
+{
+    int length = snprintf(path, PATH_MAX, "%s/%016llx%016llx" CACHE_EXTENSION, cache->directory, (unsigned long long)key[0], (unsigned long long)key[1]);
+
+    return length > 0 && length < PATH_MAX;
+}
+
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const char *bytes = (const char *)data;
+
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        bytes += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+/**
+ * Lê um arquivo inteiro.
+ * @return Memória alocada com malloc, ou NULL se o arquivo não puder ser lido.
+ */
+static char *read_file(const char *filename, size_t *size)
+{
+    FILE *file = fopen(filename, "rb");
+    struct stat info;
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    if (fstat(fileno(file), &info) < 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    char *data = (char *)malloc(info.st_size + 1);
+
+    if (data == NULL)
+    {
+        perror("Error allocating compile cache entry");
+        exit(EXIT_FAILURE);
+    }
+
+    *size = fread(data, 1, info.st_size, file);
+    fclose(file);
+
+    if (*size != (size_t)info.st_size)
+    {
+        free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+/* Remoção */
+
+static int compare_files(const void *a, const void *b)
+{
+    const CacheFile *first = (const CacheFile *)a;
+    const CacheFile *second = (const CacheFile *)b;
+
+    if (first->used.tv_sec != second->used.tv_sec)
+    {
+        return first->used.tv_sec < second->used.tv_sec ? -1 : 1;
+    }
+
+    return (first->used.tv_nsec > second->used.tv_nsec) - (first->used.tv_nsec < second->used.tv_nsec);
+}
+
+/**
+ * Recalcula o tamanho do cache e, se ele passar do limite, remove as entradas
+ * usadas há mais tempo até sobrar 3/4 do limite, para que a próxima remoção
+ * não venha logo em seguida. Deve ser chamada com cache->lock.
+ */
+static void cache_evict(CompileCache *cache)
+{
+    DIR *directory = opendir(cache->directory);
+
+    if (directory == NULL)
+    {
+        return;
+    }
+
+    CacheFile *files = NULL;
+    size_t count = 0, capacity = 0;
+    uint64_t total = 0;
+    time_t now = time(NULL);
+    struct dirent *item;
+    struct stat info;
+
+    while ((item = readdir(directory)) != NULL)
+    {
+        bool temporary = ends_with(item->d_name, CACHE_TEMPORARY_EXTENSION);
+
+        if ((!temporary && !ends_with(item->d_name, CACHE_EXTENSION)) || fstatat(dirfd(directory), item->d_name, &info, 0) < 0)
+        {
+            continue;
+        }
+
+        // Temporários recentes podem ser de outro processo, ainda escrevendo
+        if (temporary)
+        {
+            if (now - info.st_mtime > CACHE_TEMPORARY_MAX_AGE)
+            {
+                unlinkat(dirfd(directory), item->d_name, 0);
+            }
+
+            continue;
+        }
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            files = (CacheFile *)realloc(files, capacity * sizeof(CacheFile));
+
+            if (files == NULL)
+            {
+                perror("Error allocating compile cache");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        files[count].name = strdup(item->d_name);
+        files[count].used = info.st_mtim;
+        files[count].size = info.st_size;
+
+        if (files[count].name == NULL)
+        {
+            perror("Error allocating compile cache");
+            exit(EXIT_FAILURE);
+        }
+
+        total += info.st_size;
+        count++;
+    }
+
+    if (total > cache->limit)
+    {
+        qsort(files, count, sizeof(CacheFile), compare_files);
+
+        // Outro processo pode já ter removido a mesma entrada
+        for (size_t i = 0; i < count && total > cache->limit / 4 * 3; i++)
+        {
+            unlinkat(dirfd(directory), files[i].name, 0);
+            total -= files[i].size;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        free(files[i].name);
+    }
+
+    free(files);
+    closedir(directory);
+
+    cache->size = total;
+}
+
+bool compile_cache_open(CompileCache *cache, const char *directory, uint64_t limit)
+{
+    if (mkdir(directory, 0755) < 0 && errno != EEXIST)
+    {
+        perror("Error creating compile cache directory");
+        return false;
+    }
+
+    cache->directory = strdup(directory);
+
+    if (cache->directory == NULL)
+    {
+        perror("Error allocating compile cache");
+        exit(EXIT_FAILURE);
+    }
+
+    cache->limit = limit;
+    cache->size = 0;
+    cache->sequence = 0;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    pthread_mutex_lock(&cache->lock);
+    cache_evict(cache);
+    pthread_mutex_unlock(&cache->lock);
+
+    return true;
+}
+
+void compile_cache_close(CompileCache *cache)
+{
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->directory);
+    cache->directory = NULL;
+}
+
+/* Entradas */
+
+/**
+ * @return Se names tem exatamente count nomes terminados em '\0'.
+ */
+static bool names_valid(const char *names, uint32_t size, uint32_t count)
+{
+    uint32_t found = 0;
+
+    for (const char *end = names + size; names < end; names++)
+    {
+        found += *names == '\0';
+    }
+
+    return found == count && (size == 0 || names[-1] == '\0');
+}
+
+/**
+ * Reproduz a entrada da chave atual, se ela existir e for válida.
+ */
+static bool cache_read(CompilerContext *context)
+{
+    CompileCache *cache = context->options.cache;
+    const uint64_t *key = context->cache_entry.key;
+    const LogSink *sink = context->options.sink;
+    char path[PATH_MAX];
+    struct stat info;
+
+    if (!entry_path(cache, key, path))
+    {
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(CacheHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    char *data = (char *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    CacheHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    uint64_t nodes_size = (uint64_t)header.node_count * sizeof(AstNode);
+
+    // Uma entrada truncada ou de outra chave (colisão no nome do arquivo) é uma falta
+    bool valid = header.magic == CACHE_MAGIC && header.version == CACHE_FORMAT_VERSION &&
+                 header.key[0] == key[0] && header.key[1] == key[1] &&
+                 header.source_size == context->scanner.source_size &&
+                 header.output_size <= (uint64_t)info.st_size && header.log_size <= (uint64_t)info.st_size &&
+                 sizeof(CacheHeader) + header.output_size + header.log_size + nodes_size + header.names_size == (uint64_t)info.st_size &&
+                 header.node_count > 0 && header.root < header.node_count;
+
+    const char *output = data + sizeof(CacheHeader);
+    const char *log = valid ? output + header.output_size : NULL;
+    const char *nodes = valid ? log + header.log_size : NULL;
+    const char *names = valid ? nodes + nodes_size : NULL;
+
+    valid = valid && names_valid(names, header.names_size, header.symbol_count);
+
+    // O log de tokens é escrito antes da saída: se a escrita falhar, a compilação é refeita e registra o erro
+    if (valid && sink->event != NULL)
+    {
+        char log_filename[MAX_LOG_FILENAME];
+        snprintf(log_filename, sizeof(log_filename), "%s.%s", context->options.log_name, sink->extension);
+
+        FILE *file = fopen(log_filename, "w");
+
+        if (file == NULL)
+        {
+            valid = false;
+        }
+        else
+        {
+            valid = fwrite(log, 1, header.log_size, file) == header.log_size;
+            valid = fclose(file) == 0 && valid;
+        }
+    }
+
+    if (!valid)
+    {
+        munmap(data, info.st_size);
+        close(fd);
+        return false;
+    }
+
+    // A data de modificação é a do último uso, que define a ordem de remoção
+    futimens(fd, NULL);
+    close(fd);
+
+    fwrite(output, 1, header.output_size, context->options.output);
+
+    for (uint32_t position = 0; position < header.names_size;)
+    {
+        size_t length = strnlen(names + position, header.names_size - position);
+
+        symbol_table_intern(&context->symbol_table, names + position, length);
+        position += length + 1;
+    }
+
+    ast_load(&context->parser.ast, nodes, header.node_count);
+    parser_restore(context, header.root, header.error_count, header.first_error_offset, header.last_error_offset, header.recovery_offset);
+
+    munmap(data, info.st_size);
+    return true;
+}
+
+/**
+ * Grava a entrada da compilação que acabou de terminar. Falhas de escrita só
+ * deixam de guardar a entrada.
+ */
+static void cache_write(CompilerContext *context)
+{
+    CompileCache *cache = context->options.cache;
+    CompileCacheEntry *entry = &context->cache_entry;
+    const LogSink *sink = context->options.sink;
+    const Parser *parser = &context->parser;
+    const SymbolTable *symbols = &context->symbol_table;
+    char path[PATH_MAX], temporary[PATH_MAX];
+    char *log = NULL;
+    size_t log_size = 0;
+
+    if (!entry_path(cache, entry->key, path))
+    {
+        return;
+    }
+
+    if (sink->event != NULL)
+    {
+        char log_filename[MAX_LOG_FILENAME];
+        snprintf(log_filename, sizeof(log_filename), "%s.%s", context->options.log_name, sink->extension);
+
+        if ((log = read_file(log_filename, &log_size)) == NULL)
+        {
+            return;
+        }
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    uint32_t sequence = cache->sequence++;
+    pthread_mutex_unlock(&cache->lock);
+
+    int length = snprintf(temporary, sizeof(temporary), "%s.%ld.%u" CACHE_TEMPORARY_EXTENSION, path, (long)getpid(), sequence);
+
+    if (length < 0 || length >= (int)sizeof(temporary))
+    {
+        free(log);
+        return;
+    }
+
+    CacheHeader header = {0};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_FORMAT_VERSION;
+    header.key[0] = entry->key[0];
+    header.key[1] = entry->key[1];
+    header.source_size = context->scanner.source_size;
+    header.output_size = entry->text_size;
+    header.log_size = log_size;
+    header.node_count = parser->ast.count;
+    header.root = parser->root;
+    header.symbol_count = symbols->count;
+    header.names_size = symbols->names_size;
+    header.error_count = parser->error_count;
+    header.first_error_offset = parser->first_error_offset;
+    header.last_error_offset = parser->last_error_offset;
+    header.recovery_offset = parser->recovery_offset;
+
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    bool written = fd >= 0 &&
+                   write_all(fd, &header, sizeof(header)) &&
+                   write_all(fd, entry->text, entry->text_size) &&
+                   write_all(fd, log, log_size) &&
+                   write_all(fd, ast_node(&parser->ast, 0), (size_t)parser->ast.count * sizeof(AstNode)) &&
+                   write_all(fd, symbols->names, symbols->names_size);
+
+    written = fd >= 0 && close(fd) == 0 && written;
+
+    // A entrada só aparece, inteira, com o rename
+    if (!written || rename(temporary, path) < 0)
+    {
+        perror("Error writing compile cache entry");
+        unlink(temporary);
+        free(log);
+        return;
+    }
+
+    free(log);
+
+    pthread_mutex_lock(&cache->lock);
+    cache->size += sizeof(header) + entry->text_size + log_size + (uint64_t)parser->ast.count * sizeof(AstNode) + symbols->names_size;
+
+    if (cache->size > cache->limit)
+    {
+        cache_evict(cache);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+bool compile_cache_load(CompilerContext *context)
+{
+    CompileCacheEntry *entry = &context->cache_entry;
+
+    cache_key(context, entry->key);
+
+    if (cache_read(context))
+    {
+        return true;
+    }
+
+    // Falta: a saída é capturada para ser guardada com a entrada
+    entry->output = context->options.output;
+    entry->text = NULL;
+    entry->text_size = 0;
+    entry->capture = open_memstream(&entry->text, &entry->text_size);
+
+    if (entry->capture == NULL)
+    {
+        perror("Error allocating compile cache entry");
+        exit(EXIT_FAILURE);
+    }
+
+    context->options.output = entry->capture;
+    entry->active = true;
+
+    return false;
+}
+
+void compile_cache_finish(CompilerContext *context, bool completed)
+{
+    CompileCacheEntry *entry = &context->cache_entry;
+
+    if (!entry->active)
+    {
+        return;
+    }
+
+    entry->active = false;
+    fclose(entry->capture);
+    context->options.output = entry->output;
+
+    fwrite(entry->text, 1, entry->text_size, context->options.output);
+
+    if (completed)
+    {
+        cache_write(context);
+    }
+
+    free(entry->text);
+    entry->text = NULL;
+    entry->text_size = 0;
+}
@@ -1,9 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
 
-#include "logging.h"
-#include "scanner.h"
-#include "parser.h"
+#include "compiler_context.h"
+#include "batch.h"
+#include "server.h"
 
 /*
 Referências:
@@ -12,23 +15,158 @@ Referências:
 
 int main(int argc, char const *argv[])
 {
-    if (argc < 2)
+    BatchInputs inputs;
+    bool batch = false; // Mais de um arquivo, ou um arquivo de respostas
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    bool echo = true;
+    const LogSink *sink = NULL;
+    bool replay = false;
+    const char *socket_path = NULL;
+    size_t max_source = SERVER_DEFAULT_MAX_SOURCE;
+    int max_errors = PARSER_DEFAULT_MAX_ERRORS;
+    const char *cache_directory = NULL;
+    uint64_t cache_limit = COMPILE_CACHE_DEFAULT_LIMIT;
+    bool fold = false;
+
+    batch_inputs_init(&inputs);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc)
+        {
+            // 0 registra todos os erros de sintaxe
+            max_errors = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc)
+        {
+            // Compilações de um código-fonte já visto são reproduzidas do cache
+            cache_directory = argv[++i];
+        }
+        else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc)
+        {
+            // Em MiB
+            cache_limit = strtoull(argv[++i], NULL, 10) << 20;
+        }
+        else if (strncmp(argv[i], "--log=", 6) == 0)
+        {
+            // none (apenas verificação), text, jsonl ou binary
+            sink = log_sink_find(argv[i] + 6);
+
+            if (sink == NULL)
+            {
+                fprintf(stderr, "Unknown log format: %s\n", argv[i] + 6);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--replay") == 0)
+        {
+            // O arquivo é um log binário (--log=binary) e o scanner não é usado
+            replay = true;
+        }
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+        {
+            // Atende pedidos de compilação em um socket Unix, sem arquivos de entrada
+            socket_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-source") == 0 && i + 1 < argc)
+        {
+            // Em MiB, o maior código-fonte aceito pelo servidor
+            max_source = strtoull(argv[++i], NULL, 10) << 20;
+        }
+        else if (strcmp(argv[i], "--fold") == 0)
+        {
+            // Dobra as constantes dos programas sem erros e informa quantos nós foram removidos
+            fold = true;
+        }
+        else if (strcmp(argv[i], "-q") == 0)
+        {
+            // Os tokens são escritos só no arquivo .tokens
+            echo = false;
+        }
+        else if (argv[i][0] == '@')
+        {
+            // Arquivo de respostas: um arquivo de entrada por linha
+            if (!batch_inputs_add_response_file(&inputs, argv[i] + 1))
+            {
+                exit(EXIT_FAILURE);
+            }
+
+            batch = true;
+        }
+        else
+        {
+            batch_inputs_add(&inputs, argv[i]);
+        }
+    }
+
+    if (inputs.count == 0 && !batch && socket_path == NULL)
     {
-        fprintf(stderr, "Source code file not specified. Usage: %s <file>\n", argv[0]);
+        fprintf(stderr, "Source code file not specified. Usage: %s [-j threads] [-q] [--max-errors N] [--log=none|text|jsonl|binary] [--replay] [--fold] [--cache-dir <dir> [--cache-size MiB]] <file | - | @response-file>...\n", argv[0]);
+        fprintf(stderr, "       %s [-j threads] [--max-errors N] [--fold] [--cache-dir <dir> [--cache-size MiB]] [--max-source MiB] --server <socket>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    const char *program_name = argv[0];
+    // O servidor recebe o código-fonte, e não logs binários
+    if (socket_path != NULL && replay)
+    {
+        fprintf(stderr, "--replay cannot be used with --server\n");
+        exit(EXIT_FAILURE);
+    }
 
-    log_init(program_name);
-    scanner_init(argv[1]);
-    parser_init();
+    CompilerOptions options;
+    CompileCache cache;
+    CompileCache *cache_pointer = NULL;
+    bool success;
 
-    parser_parse();
+    if (cache_directory != NULL)
+    {
+        if (!compile_cache_open(&cache, cache_directory, cache_limit))
+        {
+            exit(EXIT_FAILURE);
+        }
 
-    parser_cleanup();
-    scanner_cleanup();
-    log_cleanup();
+        cache_pointer = &cache;
+    }
+
+    if (socket_path != NULL)
+    {
+        options = (CompilerOptions){argv[0], &log_sink_null, false, threads, max_errors, stdout, cache_pointer, fold};
+        success = server_run(socket_path, &options, max_source);
+    }
+    else if (batch || inputs.count > 1)
+    {
+        // Cada arquivo é analisado por uma thread do conjunto, e -j define quantas são.
+        // Sem --log, nada é registrado; com ele, o log de cada arquivo é <arquivo>.<extensão>
+        options = (CompilerOptions){argv[0], sink != NULL ? sink : &log_sink_null, false, 1, max_errors, stdout, cache_pointer, fold};
+        success = batch_compile(&inputs, &options, threads, replay);
+    }
+    else
+    {
+        CompilerContext context;
+        compiler_context_init(&context);
+
+        context.options = (CompilerOptions){argv[0], sink != NULL ? sink : &log_sink_text, echo, threads, max_errors, stdout, cache_pointer, fold};
+
+        success = replay ? compiler_replay(&context, inputs.files[0]) : compiler_compile(&context, inputs.files[0]);
+
+        if (fold && success)
+        {
+            printf("Constant folding removed %u nodes\n", context.folded);
+        }
+
+        compiler_context_free(&context);
+    }
+
+    batch_inputs_free(&inputs);
+
+    if (cache_pointer != NULL)
+    {
+        compile_cache_close(cache_pointer);
+    }
 
-    return EXIT_SUCCESS;
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
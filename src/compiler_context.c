@@ -0,0 +1,229 @@
+#include "compiler_context.h"
+
+#include <string.h>
+
+void compiler_context_init(CompilerContext *context)
+{
+    memset(context, 0, sizeof(*context));
+
+    context->options.log_name = "compiler";
+    context->options.sink = &log_sink_null;
+    context->options.echo = false;
+    context->options.threads = 1;
+    context->options.max_errors = PARSER_DEFAULT_MAX_ERRORS;
+    context->options.output = stdout;
+
+    context->scanner.stream_fd = -1;
+    symbol_table_init(&context->symbol_table);
+}
+
+/**
+ * Libera o que sobrou da compilação anterior, para que o contexto possa ser reutilizado.
+ * A memória da tabela de símbolos, dos tokens e do AST é mantida, e parser_init a reaproveita.
+ */
+static void compiler_reset(CompilerContext *context)
+{
+    scanner_cleanup(context);
+    log_cleanup(context);
+    token_dump_close(&context->dump);
+    log_set_source(context, NULL, 0, NULL);
+
+    symbol_table_clear(&context->symbol_table);
+    type_table_clear(&context->types);
+    context->editable = false;
+    context->folded = 0;
+}
+
+/**
+ * Com options.fold, dobra as constantes dos nós a partir de first, se o programa não tem erros.
+ */
+static void compiler_fold(CompilerContext *context, AstIndex first)
+{
+    if (context->options.fold && parser_error_count(context) == 0)
+    {
+        context->folded = constant_fold(context, first);
+    }
+}
+
+/**
+ * Analisa o arquivo source_filename ou, se ele for NULL, o código-fonte em source.
+ */
+static bool compiler_run(CompilerContext *context, const char *source_filename, char *source, size_t size)
+{
+    compiler_reset(context);
+
+    if (setjmp(context->failure) != 0)
+    {
+        // O erro já foi registrado; o log ainda recebe o que estava pendente.
+        // Um código-fonte com erro léxico continua disponível para compiler_edit.
+        if (!context->editable)
+        {
+            scanner_cleanup(context);
+        }
+
+        log_cleanup(context);
+        compile_cache_finish(context, false);
+        return false;
+    }
+
+    // O scanner assume o código-fonte em memória antes de qualquer falha possível
+    if (source_filename != NULL)
+    {
+        scanner_init(context, source_filename);
+    }
+    else
+    {
+        scanner_init_buffer(context, source, size);
+    }
+
+    // O código-fonte inteiro fica na memória até a próxima compilação
+    context->editable = context->scanner.stream_fd < 0;
+
+    // A entrada depende do código-fonte inteiro, então só é usada fora da leitura em fluxo
+    if (context->options.cache != NULL && context->editable && compile_cache_load(context))
+    {
+        // Os erros de tipo já estão na saída guardada; só a tabela de tipos é refeita
+        type_check(context, AST_NONE + 1, false);
+        compiler_fold(context, AST_NONE + 1);
+        return parser_error_count(context) == 0;
+    }
+
+    log_init(context);
+    scanner_set_threads(context, context->options.threads);
+    parser_init(context);
+
+    parser_parse(context);
+
+    // Na leitura em fluxo, os nós foram verificados durante a análise, enquanto as linhas estavam no índice
+    if (context->editable)
+    {
+        type_check(context, AST_NONE + 1, parser_error_count(context) == 0);
+    }
+    else
+    {
+        type_check_finish(context, parser_error_count(context) == 0);
+    }
+
+    log_cleanup(context);
+    compile_cache_finish(context, true);
+
+    // O cache guarda a árvore sem dobrar, e ela é dobrada da mesma forma depois de um acerto
+    compiler_fold(context, AST_NONE + 1);
+
+    return parser_error_count(context) == 0;
+}
+
+bool compiler_compile(CompilerContext *context, const char *source_filename)
+{
+    return compiler_run(context, source_filename, NULL, 0);
+}
+
+bool compiler_compile_source(CompilerContext *context, char *source, size_t size)
+{
+    return compiler_run(context, NULL, source, size);
+}
+
+bool compiler_replay(CompilerContext *context, const char *dump_filename)
+{
+    const LogSink *sink = context->options.sink;
+
+    compiler_reset(context);
+
+    // Nenhum token é registrado, e o log não pode sobrescrever o arquivo reproduzido
+    context->options.sink = &log_sink_null;
+
+    if (setjmp(context->failure) != 0)
+    {
+        log_cleanup(context);
+        context->options.sink = sink;
+        return false;
+    }
+
+    log_init(context);
+
+    if (!token_dump_open(&context->dump, dump_filename))
+    {
+        compiler_fail(context);
+    }
+
+    parser_init_replay(context, &context->dump);
+    parser_parse(context);
+    type_check(context, AST_NONE + 1, parser_error_count(context) == 0);
+    compiler_fold(context, AST_NONE + 1);
+
+    log_cleanup(context);
+    context->options.sink = sink;
+
+    return parser_error_count(context) == 0;
+}
+
+bool compiler_edit(CompilerContext *context, uint32_t offset, uint32_t removed, const char *text, uint32_t inserted)
+{
+    Scanner *scanner = &context->scanner;
+
+    if (!context->editable || offset > scanner->source_size || removed > scanner->source_size - offset)
+    {
+        return false;
+    }
+
+    // Os tokens guardam offsets de 32 bits
+    if (scanner->source_size - removed + inserted > UINT32_MAX)
+    {
+        fprintf(stderr, "Source file too large\n");
+        return false;
+    }
+
+    scanner_edit(context, offset, removed, text, inserted);
+
+    // Os nós criados pela reanálise são os únicos sem tipo e sem dobrar
+    AstIndex first = parser_ast(context)->count;
+
+    // Depois de erros, os erros de tipo da árvore não foram registrados (e ela não foi
+    // dobrada): mesmo que a edição corrija o trecho reanalisado, eles só aparecem na
+    // análise completa
+    bool incremental = parser_error_count(context) == 0;
+
+    // Um erro na reanálise incremental volta para cá, sem ser registrado. Um erro de
+    // tipo no trecho reanalisado também leva à análise completa, que o registra.
+    if (incremental)
+    {
+        if (setjmp(context->failure) == 0)
+        {
+            if (parser_reparse(context, offset, removed, inserted) && type_check(context, first, false) == 0)
+            {
+                context->folded = 0;
+                compiler_fold(context, first);
+                return true;
+            }
+        }
+    }
+
+    // Análise completa do código-fonte editado, que passa do scanner para a nova compilação
+    const LogSink *sink = context->options.sink;
+    char *source = scanner->source_buffer;
+    size_t size = scanner->source_size;
+
+    scanner->source_buffer = NULL;
+    scanner->source_size = 0;
+    context->options.sink = &log_sink_null;
+
+    bool success = compiler_compile_source(context, source, size);
+
+    context->options.sink = sink;
+    return success;
+}
+
+void compiler_fail(CompilerContext *context)
+{
+    longjmp(context->failure, 1);
+}
+
+void compiler_context_free(CompilerContext *context)
+{
+    parser_cleanup(context);
+    type_table_free(&context->types);
+    scanner_cleanup(context);
+    log_cleanup(context);
+    token_dump_close(&context->dump);
+    symbol_table_free(&context->symbol_table);
+}
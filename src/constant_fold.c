@@ -0,0 +1,343 @@
+#include "constant_fold.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "compiler_context.h"
+
+typedef struct
+{
+    const Ast *ast;
+    TypeTable *types;
+    uint32_t removed;
+
+    AstIndex *stack; // Nós a visitar em subtree_size, reutilizada entre as chamadas
+    uint32_t stack_capacity;
+} Folder;
+
+static void stack_push(Folder *folder, uint32_t *count, AstIndex index)
+{
+    if (*count == folder->stack_capacity)
+    {
+        folder->stack_capacity = folder->stack_capacity ? folder->stack_capacity * 2 : 64;
+        folder->stack = (AstIndex *)realloc(folder->stack, folder->stack_capacity * sizeof(AstIndex));
+
+        if (folder->stack == NULL)
+        {
+            perror("Error allocating folding stack");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    folder->stack[(*count)++] = index;
+}
+
+/**
+ * @brief Conta os nós da subárvore com uma pilha explícita, já que a árvore
+ *        não tem limite de profundidade. Folhas usam first para o símbolo ou o valor.
+ */
+static uint32_t subtree_size(Folder *folder, AstIndex index)
+{
+    const Ast *ast = folder->ast;
+    uint32_t count = 0;
+    uint32_t size = 0;
+
+    stack_push(folder, &count, index);
+
+    while (count > 0)
+    {
+        const AstNode *node = ast_node(ast, folder->stack[--count]);
+        size++;
+
+        if (node->kind == AST_IDENTIFIER || node->kind == AST_NUMBER || node->kind == AST_BOOLEAN)
+        {
+            continue;
+        }
+
+        for (AstIndex child = node->first; child != AST_NONE; child = ast_node(ast, child)->next)
+        {
+            stack_push(folder, &count, child);
+        }
+    }
+
+    return size;
+}
+
+static inline bool is_number(const AstNode *node, uint32_t value)
+{
+    return node->kind == AST_NUMBER && node->value == value;
+}
+
+static inline bool is_boolean(const AstNode *node, TokenKind value)
+{
+    return node->kind == AST_BOOLEAN && node->op == value;
+}
+
+/**
+ * @brief Coloca o nó keep, um descendente, no lugar de index. O next de index é mantido.
+ * @param removed Os nós que saem da árvore além de keep: index, os irmãos descartados e os seus descendentes.
+ */
+static void replace(Folder *folder, AstIndex index, AstIndex keep, uint32_t removed)
+{
+    AstNode *node = ast_node(folder->ast, index);
+    AstIndex next = node->next;
+
+    *node = *ast_node(folder->ast, keep);
+    node->next = next;
+
+    folder->types->types[index] = folder->types->types[keep];
+    folder->removed += removed;
+}
+
+/**
+ * @brief Transforma o nó em uma constante, descartando os seus operandos, que já são constantes.
+ */
+static void make_constant(Folder *folder, AstIndex index, AstKind kind, TokenKind op, uint32_t value, uint32_t operands)
+{
+    AstNode *node = ast_node(folder->ast, index);
+
+    node->kind = kind;
+    node->op = op;
+    node->value = value;
+
+    folder->types->types[index] = kind == AST_NUMBER ? TYPE_INTEGER : TYPE_BOOLEAN;
+    folder->removed += operands;
+}
+
+static inline void make_number(Folder *folder, AstIndex index, uint32_t value, uint32_t operands)
+{
+    make_constant(folder, index, AST_NUMBER, TOKEN_KIND_NONE, value, operands);
+}
+
+static inline void make_boolean(Folder *folder, AstIndex index, bool value, uint32_t operands)
+{
+    make_constant(folder, index, AST_BOOLEAN, value ? BOOL_TRUE : BOOL_FALSE, 0, operands);
+}
+
+static void fold_unary(Folder *folder, AstIndex index)
+{
+    const AstNode *node = ast_node(folder->ast, index);
+    const AstNode *operand = ast_node(folder->ast, node->first);
+
+    if (node->op == OP_PLUS)
+    {
+        replace(folder, index, node->first, 1);
+    }
+    else if (node->op == OP_MINUS && operand->kind == AST_NUMBER)
+    {
+        make_number(folder, index, 0u - operand->value, 1);
+    }
+    else if (node->op == OP_NOT && operand->kind == AST_BOOLEAN)
+    {
+        make_boolean(folder, index, operand->op == BOOL_FALSE, 1);
+    }
+    else if (node->op == OP_NOT && operand->kind == AST_UNARY && operand->op == OP_NOT)
+    {
+        replace(folder, index, operand->first, 2);
+    }
+}
+
+/**
+ * @brief Calcula uma operação entre duas constantes.
+ * @return false se o resultado depende da execução (divisão por zero).
+ */
+static bool evaluate_binary(TokenKind op, const AstNode *left, const AstNode *right, uint32_t *result)
+{
+    // Os valores são guardados módulo 2^32; as comparações e div os interpretam com sinal
+    uint32_t a = left->value;
+    uint32_t b = right->value;
+
+    switch (op)
+    {
+    case OP_PLUS:
+        *result = a + b;
+        return true;
+    case OP_MINUS:
+        *result = a - b;
+        return true;
+    case OP_TIMES:
+        *result = a * b;
+        return true;
+    case OP_DIV:
+        if (b == 0)
+        {
+            return false;
+        }
+
+        // INT32_MIN div -1 não cabe em 32 bits e, como as outras operações, dá a volta
+        *result = (b == UINT32_MAX) ? 0u - a : (uint32_t)((int32_t)a / (int32_t)b);
+        return true;
+    case OP_AND:
+        *result = left->op == BOOL_TRUE && right->op == BOOL_TRUE;
+        return true;
+    case OP_OR:
+        *result = left->op == BOOL_TRUE || right->op == BOOL_TRUE;
+        return true;
+    case REL_EQ:
+        *result = left->kind == AST_NUMBER ? a == b : left->op == right->op;
+        return true;
+    case REL_NE:
+        *result = left->kind == AST_NUMBER ? a != b : left->op != right->op;
+        return true;
+    case REL_LT:
+        *result = (int32_t)a < (int32_t)b;
+        return true;
+    case REL_LE:
+        *result = (int32_t)a <= (int32_t)b;
+        return true;
+    case REL_GT:
+        *result = (int32_t)a > (int32_t)b;
+        return true;
+    case REL_GE:
+        *result = (int32_t)a >= (int32_t)b;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @return O operando que o nó pode substituir por ser neutro o outro, ou AST_NONE.
+ */
+static AstIndex neutral_operand(const Ast *ast, const AstNode *node)
+{
+    AstIndex left_index = node->first;
+    AstIndex right_index = ast_node(ast, left_index)->next;
+    const AstNode *left = ast_node(ast, left_index);
+    const AstNode *right = ast_node(ast, right_index);
+
+    switch (node->op)
+    {
+    case OP_PLUS:
+        return is_number(right, 0) ? left_index : is_number(left, 0) ? right_index : AST_NONE;
+    case OP_MINUS:
+        return is_number(right, 0) ? left_index : AST_NONE;
+    case OP_TIMES:
+        return is_number(right, 1) ? left_index : is_number(left, 1) ? right_index : AST_NONE;
+    case OP_DIV:
+        return is_number(right, 1) ? left_index : AST_NONE;
+    case OP_AND:
+        return is_boolean(right, BOOL_TRUE) ? left_index : is_boolean(left, BOOL_TRUE) ? right_index : AST_NONE;
+    case OP_OR:
+        return is_boolean(right, BOOL_FALSE) ? left_index : is_boolean(left, BOOL_FALSE) ? right_index : AST_NONE;
+    default:
+        return AST_NONE;
+    }
+}
+
+static void fold_binary(Folder *folder, AstIndex index)
+{
+    const AstNode *node = ast_node(folder->ast, index);
+    const AstNode *left = ast_node(folder->ast, node->first);
+    const AstNode *right = ast_node(folder->ast, left->next);
+    uint32_t value;
+
+    if (left->kind == right->kind && (left->kind == AST_NUMBER || left->kind == AST_BOOLEAN))
+    {
+        if (evaluate_binary(node->op, left, right, &value))
+        {
+            if (type_of(folder->types, index) == TYPE_INTEGER)
+            {
+                make_number(folder, index, value, 2);
+            }
+            else
+            {
+                make_boolean(folder, index, value != 0, 2);
+            }
+        }
+
+        return;
+    }
+
+    // O operando mantido tem o tipo do resultado, o que vale para as identidades quando não há erros de tipo
+    AstIndex keep = neutral_operand(folder->ast, node);
+
+    if (keep != AST_NONE && type_of(folder->types, keep) == type_of(folder->types, index))
+    {
+        // O nó e a constante descartada
+        replace(folder, index, keep, 2);
+    }
+}
+
+static void fold_if(Folder *folder, AstIndex index)
+{
+    AstNode *node = ast_node(folder->ast, index);
+    const AstNode *condition = ast_node(folder->ast, node->first);
+
+    if (condition->kind != AST_BOOLEAN)
+    {
+        return;
+    }
+
+    AstIndex then_statement = condition->next;
+    AstIndex else_statement = ast_node(folder->ast, then_statement)->next;
+    AstIndex keep = condition->op == BOOL_TRUE ? then_statement : else_statement;
+    AstIndex discard = condition->op == BOOL_TRUE ? else_statement : then_statement;
+    uint32_t removed = 1 + (discard != AST_NONE ? subtree_size(folder, discard) : 0);
+
+    if (keep != AST_NONE)
+    {
+        // O if e a condição saem, o ramo escolhido fica no lugar
+        replace(folder, index, keep, removed + 1);
+    }
+    else
+    {
+        node->kind = AST_EMPTY;
+        node->op = TOKEN_KIND_NONE;
+        node->first = AST_NONE;
+        folder->removed += removed;
+    }
+}
+
+static void fold_while(Folder *folder, AstIndex index)
+{
+    AstNode *node = ast_node(folder->ast, index);
+    const AstNode *condition = ast_node(folder->ast, node->first);
+
+    // while true é um laço infinito, que continua na árvore
+    if (!is_boolean(condition, BOOL_FALSE))
+    {
+        return;
+    }
+
+    folder->removed += 1 + subtree_size(folder, condition->next);
+
+    node->kind = AST_EMPTY;
+    node->op = TOKEN_KIND_NONE;
+    node->first = AST_NONE;
+}
+
+uint32_t constant_fold(CompilerContext *context, AstIndex first)
+{
+    Folder folder = {parser_ast(context), &context->types, 0, NULL, 0};
+    const Ast *ast = folder.ast;
+
+    for (AstIndex index = first; index < ast->count; index++)
+    {
+        switch (ast_node(ast, index)->kind)
+        {
+        case AST_UNARY:
+            fold_unary(&folder, index);
+            break;
+
+        case AST_BINARY:
+            fold_binary(&folder, index);
+            break;
+
+        case AST_IF:
+            fold_if(&folder, index);
+            break;
+
+        case AST_WHILE:
+            fold_while(&folder, index);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    free(folder.stack);
+    return folder.removed;
+}
@@ -0,0 +1,24 @@
+#include "keyword_hash.h"
+
+#include <string.h>
+
+#include "keyword_table.h"
+
+const KeywordEntry *keyword_lookup(const char *start, size_t length)
+{
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
+    {
+        return NULL;
+    }
+
+    uint32_t hash = keyword_hash(start, length);
+    uint32_t displacement = keyword_displacements[hash % KEYWORD_BUCKET_COUNT];
+    const KeywordEntry *entry = &keyword_table[keyword_slot(hash, displacement, KEYWORD_TABLE_SIZE)];
+
+    if (entry->length != length || memcmp(entry->word, start, length) != 0)
+    {
+        return NULL;
+    }
+
+    return entry;
+}
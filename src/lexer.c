@@ -0,0 +1,323 @@
+#include "lexer.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "keyword_hash.h"
+#include "simd_scan.h"
+
+/*
+Autômato finito determinístico do analisador léxico.
+
+<identificador>          ::= <letra> {<letra> | <dígito>}
+<numero>                 ::= <digito> {<digito>}
+<operador aritmético>    ::= + | - | *
+<operador relacional>    ::= = | <> | < | <= | > | >=
+<operador de atribuição> ::= :=
+<delimitador>            ::= ( | ) | , | : | . | ;
+
+Palavras reservadas, booleanos e os operadores escritos por extenso (div, and,
+or, not) são reconhecidos como identificadores pelo autômato e reclassificados
+depois pela tabela hash perfeita gerada a partir de src/token.c (keyword_hash.h).
+*/
+
+typedef enum
+{
+    CLASS_OTHER,
+    CLASS_LETTER,     // _ | a ... z | A ... Z
+    CLASS_DIGIT,      // 0 ... 9
+    CLASS_ARITHMETIC, // + | - | *
+    CLASS_EQUAL,      // =
+    CLASS_LESS,       // <
+    CLASS_GREATER,    // >
+    CLASS_COLON,      // :
+    CLASS_DELIMITER,  // ( | ) | , | . | ;
+    CLASS_COUNT
+} CharClass;
+
+typedef enum
+{
+    STATE_DEAD,
+    STATE_START,
+    STATE_IDENTIFIER,
+    STATE_NUMBER,
+    STATE_ARITHMETIC,
+    STATE_LESS,       // <
+    STATE_GREATER,    // >
+    STATE_RELATIONAL, // = | <> | <= | >=
+    STATE_COLON,      // :
+    STATE_ASSIGNMENT, // :=
+    STATE_DELIMITER,
+    STATE_COUNT
+} LexerState;
+
+static const unsigned char char_classes[256] = {
+    ['_'] = CLASS_LETTER,
+    ['a' ... 'z'] = CLASS_LETTER,
+    ['A' ... 'Z'] = CLASS_LETTER,
+    ['0' ... '9'] = CLASS_DIGIT,
+    ['+'] = CLASS_ARITHMETIC,
+    ['-'] = CLASS_ARITHMETIC,
+    ['*'] = CLASS_ARITHMETIC,
+    ['='] = CLASS_EQUAL,
+    ['<'] = CLASS_LESS,
+    ['>'] = CLASS_GREATER,
+    [':'] = CLASS_COLON,
+    ['('] = CLASS_DELIMITER,
+    [')'] = CLASS_DELIMITER,
+    [','] = CLASS_DELIMITER,
+    ['.'] = CLASS_DELIMITER,
+    [';'] = CLASS_DELIMITER,
+};
+
+// Transições ausentes levam a STATE_DEAD (0)
+static const unsigned char transitions[STATE_COUNT][CLASS_COUNT] = {
+    [STATE_START] = {
+        [CLASS_LETTER] = STATE_IDENTIFIER,
+        [CLASS_DIGIT] = STATE_NUMBER,
+        [CLASS_ARITHMETIC] = STATE_ARITHMETIC,
+        [CLASS_EQUAL] = STATE_RELATIONAL,
+        [CLASS_LESS] = STATE_LESS,
+        [CLASS_GREATER] = STATE_GREATER,
+        [CLASS_COLON] = STATE_COLON,
+        [CLASS_DELIMITER] = STATE_DELIMITER,
+    },
+    [STATE_IDENTIFIER] = {
+        [CLASS_LETTER] = STATE_IDENTIFIER,
+        [CLASS_DIGIT] = STATE_IDENTIFIER,
+    },
+    [STATE_NUMBER] = {
+        [CLASS_DIGIT] = STATE_NUMBER,
+    },
+    [STATE_LESS] = {
+        [CLASS_GREATER] = STATE_RELATIONAL,
+        [CLASS_EQUAL] = STATE_RELATIONAL,
+    },
+    [STATE_GREATER] = {
+        [CLASS_EQUAL] = STATE_RELATIONAL,
+    },
+    [STATE_COLON] = {
+        [CLASS_EQUAL] = STATE_ASSIGNMENT,
+    },
+};
+
+// Tipo do token reconhecido em cada estado final
+static const TokenType accepting_types[STATE_COUNT] = {
+    [STATE_IDENTIFIER] = TOKEN_IDENTIFIER,
+    [STATE_NUMBER] = TOKEN_NUMBER,
+    [STATE_ARITHMETIC] = TOKEN_OPERATOR_ARITHMETIC,
+    [STATE_LESS] = TOKEN_OPERATOR_RELATIONAL,
+    [STATE_GREATER] = TOKEN_OPERATOR_RELATIONAL,
+    [STATE_RELATIONAL] = TOKEN_OPERATOR_RELATIONAL,
+    [STATE_COLON] = TOKEN_DELIMITER,
+    [STATE_ASSIGNMENT] = TOKEN_OPERATOR_ASSIGNMENT,
+    [STATE_DELIMITER] = TOKEN_DELIMITER,
+};
+
+// TokenKind de cada estado final que reconhece um único lexema
+static const signed char state_kinds[STATE_COUNT] = {
+    [STATE_LESS] = REL_LT,
+    [STATE_GREATER] = REL_GT,
+    [STATE_COLON] = DELIM_COLON,
+    [STATE_ASSIGNMENT] = OP_ASSIGN,
+};
+
+// TokenKind dos operadores e delimitadores de um caractere
+static const signed char char_kinds[256] = {
+    ['+'] = OP_PLUS,
+    ['-'] = OP_MINUS,
+    ['*'] = OP_TIMES,
+    ['='] = REL_EQ,
+    ['('] = DELIM_LPAREN,
+    [')'] = DELIM_RPAREN,
+    [','] = DELIM_COMMA,
+    ['.'] = DELIM_DOT,
+    [';'] = DELIM_SEMI,
+};
+
+/**
+ * TokenKind de um operador ou delimitador reconhecido no estado final state.
+ */
+static inline TokenKind symbol_kind(int state, const char *start, size_t length)
+{
+    switch (state)
+    {
+    case STATE_ARITHMETIC:
+    case STATE_DELIMITER:
+        return char_kinds[(unsigned char)start[0]];
+    case STATE_RELATIONAL:
+        // = | <> | <= | >=
+        if (length == 1)
+        {
+            return REL_EQ;
+        }
+        return start[1] == '>' ? REL_NE : start[0] == '<' ? REL_LE : REL_GE;
+    default:
+        return state_kinds[state];
+    }
+}
+
+void lexer_init(Lexer *lexer, const char *source, size_t size, const char *start, const char *limit)
+{
+    lexer->source = source;
+    lexer->base_offset = 0;
+    lexer->end = source + size;
+    lexer->limit = limit;
+    lexer->cursor = start;
+    lexer->at_eof = true;
+    lexer->in_comment = false;
+    lexer->comment_offset = 0;
+}
+
+void lexer_set_window(Lexer *lexer, const char *source, size_t size, uint32_t base_offset, const char *cursor, bool at_eof)
+{
+    lexer->source = source;
+    lexer->base_offset = base_offset;
+    lexer->end = source + size;
+    lexer->limit = lexer->end;
+    lexer->cursor = cursor;
+    lexer->at_eof = at_eof;
+}
+
+void lexer_skip_comment(Lexer *lexer)
+{
+    lexer->in_comment = true;
+    lexer->comment_offset = lexer->cursor - lexer->source + lexer->base_offset;
+
+    // O último caractere pode ser o '*' de um "*/" dividido entre duas leituras
+    lexer->cursor = lexer->end - 1;
+}
+
+static inline uint32_t lexer_offset(const Lexer *lexer, const char *position)
+{
+    return position - lexer->source + lexer->base_offset;
+}
+
+/**
+ * Procura o fim do comentário iniciado em comment_offset a partir do cursor.
+ */
+static LexResult lexer_finish_comment(Lexer *lexer, Token *token, uint32_t comment_offset, const char *search)
+{
+    const char *comment_close = simd_find_comment_end(search, lexer->end);
+
+    if (comment_close == NULL)
+    {
+        if (!lexer->at_eof)
+        {
+            return LEX_NEED_MORE;
+        }
+
+        lexer->cursor = lexer->end;
+        lexer->in_comment = false;
+        *token = create_token(TOKEN_COMMENT, TOKEN_KIND_NONE, comment_offset, lexer_offset(lexer, lexer->end) - comment_offset);
+        return LEX_UNTERMINATED_COMMENT;
+    }
+
+    lexer->cursor = comment_close + 2;
+    lexer->in_comment = false;
+    *token = create_token(TOKEN_COMMENT, TOKEN_KIND_NONE, comment_offset, lexer_offset(lexer, lexer->cursor) - comment_offset);
+    return LEX_COMMENT;
+}
+
+LexResult lexer_next(Lexer *lexer, Token *token)
+{
+    const char *cursor = lexer->cursor;
+    const char *end = lexer->end;
+
+    if (__builtin_expect(lexer->in_comment, 0))
+    {
+        LexResult result = lexer_finish_comment(lexer, token, lexer->comment_offset, cursor);
+
+        if (result == LEX_NEED_MORE)
+        {
+            lexer->cursor = end - 1;
+        }
+
+        return result;
+    }
+
+    // 1. Pular espaços em branco
+    cursor = simd_skip_whitespace(cursor, end);
+
+    if (cursor == end && !lexer->at_eof)
+    {
+        lexer->cursor = cursor;
+        return LEX_NEED_MORE;
+    }
+
+    if (cursor >= lexer->limit)
+    {
+        lexer->cursor = cursor;
+        return LEX_END;
+    }
+
+    lexer->cursor = cursor;
+
+    // Reconhecer comentários
+    if (cursor[0] == '/')
+    {
+        if (cursor + 1 == end && !lexer->at_eof)
+        {
+            return LEX_NEED_MORE;
+        }
+
+        if (cursor + 1 < end && cursor[1] == '*')
+        {
+            return lexer_finish_comment(lexer, token, lexer_offset(lexer, cursor), cursor + 2);
+        }
+    }
+
+    // 2. Percorrer o autômato até a maior correspondência
+    const char *token_start = cursor;
+    int state = STATE_START;
+
+    while (cursor < end)
+    {
+        int next_state = transitions[state][char_classes[(unsigned char)*cursor]];
+
+        if (next_state == STATE_DEAD)
+        {
+            break;
+        }
+
+        state = next_state;
+        cursor++;
+    }
+
+    // O token pode continuar nos próximos bytes
+    if (cursor == end && !lexer->at_eof)
+    {
+        return LEX_NEED_MORE;
+    }
+
+    lexer->cursor = cursor;
+
+    // Nenhum token foi reconhecido
+    if (state == STATE_START)
+    {
+        *token = create_token(TOKEN_EOF, TOKEN_KIND_NONE, lexer_offset(lexer, token_start), 1);
+        return LEX_INVALID_CHARACTER;
+    }
+
+    // 3. Criar o token com base no estado final
+    TokenType type = accepting_types[state];
+    TokenKind kind = TOKEN_KIND_NONE;
+
+    if (state == STATE_IDENTIFIER)
+    {
+        const KeywordEntry *keyword = keyword_lookup(token_start, cursor - token_start);
+
+        if (keyword != NULL)
+        {
+            type = keyword->type;
+            kind = keyword->kind;
+        }
+    }
+    else if (state != STATE_NUMBER)
+    {
+        kind = symbol_kind(state, token_start, cursor - token_start);
+    }
+
+    *token = create_token(type, kind, lexer_offset(lexer, token_start), cursor - token_start);
+    return LEX_TOKEN;
+}
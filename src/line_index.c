@@ -0,0 +1,181 @@
+#include "line_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd_scan.h"
+
+void line_index_init(LineIndex *index, const char *source, size_t size)
+{
+    index->source = source;
+    index->size = size;
+    index->line_starts = NULL;
+    index->line_count = 0;
+    index->capacity = 0;
+    index->first_line = 1;
+    index->hint = 0;
+}
+
+void line_index_init_stream(LineIndex *index, size_t capacity)
+{
+    line_index_init(index, NULL, 0);
+
+    // Uma linha por byte da janela, mais a linha que começa antes dela
+    index->capacity = capacity + 2;
+    index->line_starts = (uint32_t *)malloc(index->capacity * sizeof(uint32_t));
+
+    if (index->line_starts == NULL)
+    {
+        perror("Error allocating line index");
+        exit(EXIT_FAILURE);
+    }
+
+    index->line_starts[0] = 0;
+    index->line_count = 1;
+}
+
+void line_index_append(LineIndex *index, const char *data, size_t length, uint32_t base_offset)
+{
+    // No pior caso, cada byte é uma quebra de linha. O índice só passa da capacidade
+    // inicial enquanto as linhas de um comando longo são mantidas fora da janela
+    if (index->line_count + length > index->capacity)
+    {
+        uint64_t capacity = (uint64_t)index->capacity * 2;
+
+        while (capacity < index->line_count + length)
+        {
+            capacity *= 2;
+        }
+
+        if (capacity > UINT32_MAX)
+        {
+            capacity = UINT32_MAX;
+        }
+
+        uint32_t *line_starts = (uint32_t *)realloc(index->line_starts, capacity * sizeof(uint32_t));
+
+        if (line_starts == NULL)
+        {
+            perror("Error allocating line index");
+            exit(EXIT_FAILURE);
+        }
+
+        index->line_starts = line_starts;
+        index->capacity = capacity;
+    }
+
+    uint32_t *positions = index->line_starts + index->line_count;
+    size_t newlines = simd_collect_newlines(data, data + length, positions);
+
+    for (size_t i = 0; i < newlines; i++)
+    {
+        positions[i] += base_offset + 1;
+    }
+
+    index->line_count += newlines;
+}
+
+void line_index_discard(LineIndex *index, uint32_t offset)
+{
+    uint32_t first = 0;
+
+    while (first + 1 < index->line_count && index->line_starts[first + 1] <= offset)
+    {
+        first++;
+    }
+
+    if (first == 0)
+    {
+        return;
+    }
+
+    memmove(index->line_starts, index->line_starts + first, (index->line_count - first) * sizeof(uint32_t));
+    index->line_count -= first;
+    index->first_line += first;
+    index->hint = 0;
+}
+
+static void line_index_build(LineIndex *index)
+{
+    const char *end = index->source + index->size;
+    size_t newlines = simd_count_newlines(index->source, end);
+
+    index->line_starts = (uint32_t *)malloc((newlines + 1) * sizeof(uint32_t));
+
+    if (index->line_starts == NULL)
+    {
+        perror("Error allocating line index");
+        exit(EXIT_FAILURE);
+    }
+
+    // Cada linha começa logo após uma quebra de linha
+    index->line_starts[0] = 0;
+    simd_collect_newlines(index->source, end, index->line_starts + 1);
+
+    for (size_t i = 1; i <= newlines; i++)
+    {
+        index->line_starts[i]++;
+    }
+
+    index->line_count = newlines + 1;
+}
+
+static inline int line_contains(const LineIndex *index, uint32_t line, uint32_t offset)
+{
+    return index->line_starts[line] <= offset && (line + 1 == index->line_count || offset < index->line_starts[line + 1]);
+}
+
+void line_index_locate(LineIndex *index, uint32_t offset, int *line, int *column)
+{
+    if (index->line_count == 0)
+    {
+        line_index_build(index);
+    }
+
+    uint32_t found = index->hint;
+
+    if (!line_contains(index, found, offset))
+    {
+        if (found + 1 < index->line_count && line_contains(index, found + 1, offset))
+        {
+            found++;
+        }
+        else
+        {
+            // Última linha que começa em uma posição <= offset
+            uint32_t low = 0;
+            uint32_t high = index->line_count;
+
+            while (high - low > 1)
+            {
+                uint32_t middle = low + (high - low) / 2;
+
+                if (index->line_starts[middle] <= offset)
+                {
+                    low = middle;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+
+            found = low;
+        }
+    }
+
+    index->hint = found;
+    *line = index->first_line + found;
+
+    if (column != NULL)
+    {
+        *column = offset - index->line_starts[found] + 1;
+    }
+}
+
+void line_index_free(LineIndex *index)
+{
+    free(index->line_starts);
+    line_index_init(index, NULL, 0);
+}
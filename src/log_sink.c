@@ -0,0 +1,329 @@
+#include "log_sink.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbol_table.h"
+#include "token_dump.h"
+
+void output_flush(LogOutput *output)
+{
+    fwrite(output->data, 1, output->length, output->file);
+    fflush(output->file);
+    output->length = 0;
+}
+
+void output_write(LogOutput *output, const char *data, size_t length)
+{
+    while (output->length + length > LOG_OUTPUT_BUFFER)
+    {
+        size_t part = LOG_OUTPUT_BUFFER - output->length;
+
+        memcpy(output->data + output->length, data, part);
+        output->length += part;
+        output_flush(output);
+
+        data += part;
+        length -= part;
+    }
+
+    memcpy(output->data + output->length, data, length);
+    output->length += length;
+}
+
+static inline void output_char(LogOutput *output, char ch)
+{
+    if (output->length == LOG_OUTPUT_BUFFER)
+    {
+        output_flush(output);
+    }
+
+    output->data[output->length++] = ch;
+}
+
+/**
+ * Escreve um inteiro em decimal com pelo menos width dígitos, como "%0*d".
+ */
+static void output_number(LogOutput *output, long value, int width)
+{
+    char digits[24];
+    int count = 0;
+    unsigned long magnitude = value < 0 ? -(unsigned long)value : (unsigned long)value;
+
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    while (count < width)
+    {
+        digits[count++] = '0';
+    }
+
+    if (value < 0)
+    {
+        output_char(output, '-');
+    }
+
+    while (count > 0)
+    {
+        output_char(output, digits[--count]);
+    }
+}
+
+static inline void output_string(LogOutput *output, const char *text)
+{
+    output_write(output, text, strlen(text));
+}
+
+void log_write_diagnostic(LogOutput *output, const LogEvent *event)
+{
+    switch (event->kind)
+    {
+    case LOG_EVENT_LEXICAL_ERROR:
+    {
+        char message[128];
+        char invalid_char = event->text[0];
+        int length = snprintf(message, sizeof(message), "Lexical Error at line %02d: invalid character '%c' (ASCII code: %d)\n", event->line, invalid_char, invalid_char);
+        output_write(output, message, length);
+        break;
+    }
+
+    case LOG_EVENT_SYNTAX_ERROR:
+        output_string(output, "Syntax Error at line ");
+        output_number(output, event->line, 2);
+        output_string(output, ", column ");
+        output_number(output, event->column, 2);
+        output_string(output, ": Unexpected token '");
+        output_write(output, event->text, event->length);
+        output_string(output, "' of type ");
+        output_string(output, token_type_to_string(event->type));
+        output_char(output, '\n');
+        break;
+
+    case LOG_EVENT_END_OF_FILE:
+        output_string(output, "Syntax Error: Unexpected end of file\n");
+        break;
+
+    case LOG_EVENT_SEMANTIC_ERROR:
+        output_string(output, "Semantic Error at line ");
+        output_number(output, event->line, 2);
+        output_string(output, ", column ");
+        output_number(output, event->column, 2);
+        output_string(output, ": ");
+        output_write(output, event->text, event->length);
+        output_char(output, '\n');
+        break;
+
+    case LOG_EVENT_TOKEN:
+    case LOG_EVENT_END_OF_INPUT:
+        break;
+    }
+}
+
+/* Texto: "%02d # %-30s | %.*s\n", o formato original do arquivo .tokens */
+
+static void text_event(LogOutput *output, const LogEvent *event)
+{
+    if (event->kind != LOG_EVENT_TOKEN)
+    {
+        return;
+    }
+
+    const char *type = token_type_to_string(event->type);
+    size_t type_length = strlen(type);
+
+    output_number(output, event->line, 2);
+    output_write(output, " # ", 3);
+    output_write(output, type, type_length);
+
+    while (type_length++ < 30)
+    {
+        output_char(output, ' ');
+    }
+
+    output_write(output, " | ", 3);
+    output_write(output, event->text, event->length);
+    output_char(output, '\n');
+}
+
+/* JSON lines: um objeto por token ou erro */
+
+static void json_string(LogOutput *output, const char *text, size_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    output_char(output, '"');
+
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char ch = text[i];
+
+        if (ch == '"' || ch == '\\')
+        {
+            output_char(output, '\\');
+            output_char(output, ch);
+        }
+        else if (ch == '\n')
+        {
+            output_write(output, "\\n", 2);
+        }
+        else if (ch == '\t')
+        {
+            output_write(output, "\\t", 2);
+        }
+        else if (ch < 0x20)
+        {
+            output_write(output, "\\u00", 4);
+            output_char(output, hex[ch >> 4]);
+            output_char(output, hex[ch & 15]);
+        }
+        else
+        {
+            output_char(output, ch);
+        }
+    }
+
+    output_char(output, '"');
+}
+
+static void jsonl_event(LogOutput *output, const LogEvent *event)
+{
+    static const char *const error_names[] = {
+        [LOG_EVENT_LEXICAL_ERROR] = "lexical",
+        [LOG_EVENT_SYNTAX_ERROR] = "syntax",
+        [LOG_EVENT_END_OF_FILE] = "end_of_file",
+        [LOG_EVENT_SEMANTIC_ERROR] = "semantic",
+    };
+
+    if (event->kind == LOG_EVENT_END_OF_INPUT)
+    {
+        return;
+    }
+
+    if (event->kind == LOG_EVENT_TOKEN)
+    {
+        output_string(output, "{\"type\":\"");
+        output_string(output, token_type_to_string(event->type));
+    }
+    else
+    {
+        output_string(output, "{\"error\":\"");
+        output_string(output, error_names[event->kind]);
+    }
+
+    if (event->kind != LOG_EVENT_END_OF_FILE)
+    {
+        output_string(output, "\",\"line\":");
+        output_number(output, event->line, 1);
+
+        if (event->kind == LOG_EVENT_SYNTAX_ERROR || event->kind == LOG_EVENT_SEMANTIC_ERROR)
+        {
+            output_string(output, ",\"column\":");
+            output_number(output, event->column, 1);
+        }
+
+        output_string(output, ",\"offset\":");
+        output_number(output, event->offset, 1);
+        output_string(output, ",\"text\":");
+        json_string(output, event->text, event->length);
+        output_string(output, "}\n");
+    }
+    else
+    {
+        output_string(output, "\"}\n");
+    }
+}
+
+/* Binário: o formato descrito em token_dump.h */
+
+typedef struct
+{
+    SymbolTable strings; // Textos internados dos tokens
+    uint32_t records;
+} BinaryState;
+
+static void binary_begin(LogOutput *output)
+{
+    // O cabeçalho é reescrito com os tamanhos reais ao final
+    TokenDumpHeader header = {TOKEN_DUMP_MAGIC, TOKEN_DUMP_VERSION, 0, 0, sizeof(TokenDumpHeader), 0, 0};
+    BinaryState *state = (BinaryState *)malloc(sizeof(BinaryState));
+
+    if (state == NULL)
+    {
+        perror("Error allocating token dump");
+        exit(EXIT_FAILURE);
+    }
+
+    symbol_table_init(&state->strings);
+    state->records = 0;
+    output->state = state;
+
+    output_write(output, (const char *)&header, sizeof(header));
+}
+
+static void binary_event(LogOutput *output, const LogEvent *event)
+{
+    if (event->kind != LOG_EVENT_TOKEN && event->kind != LOG_EVENT_END_OF_INPUT)
+    {
+        return;
+    }
+
+    BinaryState *state = (BinaryState *)output->state;
+    TokenDumpRecord record = {0};
+
+    record.type = event->type;
+    record.kind = event->token_kind;
+    record.offset = event->offset;
+    record.length = event->span;
+    record.line = event->line;
+    record.column = event->column;
+    record.string = event->kind == LOG_EVENT_TOKEN ? symbol_table_intern(&state->strings, event->text, event->length) : SYMBOL_NONE;
+
+    output_write(output, (const char *)&record, sizeof(record));
+    state->records++;
+}
+
+static void binary_end(LogOutput *output)
+{
+    BinaryState *state = (BinaryState *)output->state;
+    SymbolTable *strings = &state->strings;
+    TokenDumpHeader header = {TOKEN_DUMP_MAGIC, TOKEN_DUMP_VERSION, state->records, strings->count, sizeof(TokenDumpHeader), 0, strings->names_size};
+
+    header.strings_offset = sizeof(TokenDumpHeader) + (uint64_t)state->records * sizeof(TokenDumpRecord);
+
+    output_write(output, (const char *)strings->offsets, strings->count * sizeof(uint32_t));
+    output_write(output, (const char *)strings->lengths, strings->count * sizeof(uint32_t));
+    output_write(output, strings->names, strings->names_size);
+    output_flush(output);
+
+    if (fseek(output->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, output->file) != 1)
+    {
+        perror("Error writing token dump");
+    }
+
+    symbol_table_free(strings);
+    free(state);
+    output->state = NULL;
+}
+
+const LogSink log_sink_null = {"none", NULL, false, NULL, NULL, NULL};
+const LogSink log_sink_text = {"text", "tokens", true, NULL, text_event, NULL};
+const LogSink log_sink_jsonl = {"jsonl", "tokens.jsonl", false, NULL, jsonl_event, NULL};
+const LogSink log_sink_binary = {"binary", "tokens.bin", false, binary_begin, binary_event, binary_end};
+
+const LogSink *log_sink_find(const char *name)
+{
+    static const LogSink *const sinks[] = {&log_sink_null, &log_sink_text, &log_sink_jsonl, &log_sink_binary};
+
+    for (size_t i = 0; i < sizeof(sinks) / sizeof(sinks[0]); i++)
+    {
+        if (strcmp(sinks[i]->name, name) == 0)
+        {
+            return sinks[i];
+        }
+    }
+
+    return NULL;
+}
@@ -1,74 +1,443 @@
 #include "logging.h"
 
+#include "compiler_context.h"
+
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <time.h>
+
+/*
+Log assíncrono.
+
+O scanner e o parser só copiam cada evento para um registro binário de tamanho
+fixo em um buffer circular sem locks, com um único produtor (a thread
+principal) e um único consumidor. Uma thread de escrita entrega os registros
+à sink escolhida, que os formata em lotes grandes para o arquivo de log.
+
+Textos que não cabem no registro continuam nos registros seguintes, usados
+como bytes brutos. Os erros passam pelo mesmo buffer, então aparecem na saída
+depois dos tokens que os precedem. Com a sink nula não há buffer nem thread:
+log_token retorna imediatamente e só os erros são escritos, diretamente.
+*/
+
+#define LOG_RING_SLOTS 16384 // Potência de 2
+#define LOG_RECORD_TEXT 40
 
-static FILE *token_file;
+typedef struct
+{
+    uint8_t kind; // LogEventKind
+    uint8_t type; // TokenType
+    int16_t token_kind;
+    uint32_t length; // Tamanho total do texto
+    int32_t line;
+    int32_t column;
+    uint32_t offset;
+    uint32_t span;
+    char text[LOG_RECORD_TEXT]; // Início do texto
+} LogRecord;
 
-void log_init(const char *program_name)
+union LogSlot
 {
-    char token_filename[MAX_LOG_FILENAME];
-    snprintf(token_filename, sizeof(token_filename), "%s.tokens", program_name);
+    LogRecord record;
+    char text[sizeof(LogRecord)]; // Continuação do texto de um registro
+};
+
+static void *log_writer(void *argument);
 
-    token_file = fopen(token_filename, "w");
-    if (token_file == NULL)
+static void *checked_malloc(size_t size)
+{
+    void *result = malloc(size);
+
+    if (result == NULL)
     {
-        perror("Error opening token output file");
+        perror("Error allocating log buffer");
         exit(EXIT_FAILURE);
     }
+
+    return result;
 }
 
-void log_token(const Token *token)
+void log_init(CompilerContext *context)
 {
-    if (token == NULL)
+    Logger *logger = &context->logger;
+    const LogSink *sink = context->options.sink;
+
+    // O código-fonte pode já ter sido definido pelo scanner
+    logger->sink = sink;
+    logger->active = sink->event != NULL;
+    logger->echo = context->options.echo && sink->echo;
+    logger->file = NULL;
+    logger->ring = NULL;
+    logger->head = logger->tail = logger->cached_tail = 0;
+    logger->closing = false;
+    logger->file_output = NULL;
+
+    logger->stdout_output = (LogOutput *)checked_malloc(sizeof(LogOutput));
+    logger->stdout_output->file = context->options.output;
+    logger->stdout_output->length = 0;
+    logger->stdout_output->state = NULL;
+
+    // Verificação sem log: os erros são escritos diretamente
+    if (!logger->active)
     {
         return;
     }
 
-    if (token_file)
+    char log_filename[MAX_LOG_FILENAME];
+    snprintf(log_filename, sizeof(log_filename), "%s.%s", context->options.log_name, sink->extension);
+
+    logger->file = fopen(log_filename, "w");
+    if (logger->file == NULL)
+    {
+        perror("Error opening token output file");
+        logger->active = false;
+        compiler_fail(context);
+    }
+
+    logger->ring = (LogSlot *)checked_malloc(LOG_RING_SLOTS * sizeof(LogSlot));
+    logger->file_output = (LogOutput *)checked_malloc(sizeof(LogOutput));
+    logger->file_output->file = logger->file;
+    logger->file_output->length = 0;
+    logger->file_output->state = NULL;
+
+    if (sink->begin != NULL)
+    {
+        sink->begin(logger->file_output);
+    }
+
+    if (pthread_create(&logger->writer_thread, NULL, log_writer, logger) != 0)
+    {
+        perror("Error starting log writer");
+
+        if (sink->end != NULL)
+        {
+            sink->end(logger->file_output);
+        }
+
+        logger->active = false;
+        compiler_fail(context);
+    }
+}
+
+void log_set_source(CompilerContext *context, const char *source, uint32_t base_offset, LineIndex *lines)
+{
+    Logger *logger = &context->logger;
+
+    logger->source = source;
+    logger->source_offset = base_offset;
+    logger->lines = lines;
+}
+
+/**
+ * @return O texto do código-fonte que começa em offset.
+ */
+static inline const char *source_text(const Logger *logger, uint32_t offset)
+{
+    return logger->source + (offset - logger->source_offset);
+}
+
+/* Produtor */
+
+/**
+ * @return O próximo registro livre do buffer, esperando a thread de escrita se ele estiver cheio.
+ */
+static LogSlot *ring_reserve(Logger *logger)
+{
+    if (logger->head - logger->cached_tail == LOG_RING_SLOTS)
+    {
+        while ((logger->cached_tail = __atomic_load_n(&logger->tail, __ATOMIC_ACQUIRE)) + LOG_RING_SLOTS == logger->head)
+        {
+            sched_yield();
+        }
+    }
+
+    return &logger->ring[logger->head & (LOG_RING_SLOTS - 1)];
+}
+
+static inline void ring_publish(Logger *logger)
+{
+    __atomic_store_n(&logger->head, logger->head + 1, __ATOMIC_RELEASE);
+}
+
+static void log_push(Logger *logger, const LogEvent *event)
+{
+    LogRecord *record = &ring_reserve(logger)->record;
+    const char *text = event->text;
+    uint32_t length = event->length;
+    uint32_t copied = length < LOG_RECORD_TEXT ? length : LOG_RECORD_TEXT;
+
+    record->kind = event->kind;
+    record->type = event->type;
+    record->token_kind = event->token_kind;
+    record->length = length;
+    record->line = event->line;
+    record->column = event->column;
+    record->offset = event->offset;
+    record->span = event->span;
+
+    if (copied > 0)
+    {
+        memcpy(record->text, text, copied);
+    }
+
+    ring_publish(logger);
+
+    while (copied < length)
     {
-        char log_line[MAX_LOG_LINE];
-        snprintf(log_line, sizeof(log_line), "%02d # %-30s | %s\n", token->line, token_type_to_string(token->type), token->value);
+        LogSlot *slot = ring_reserve(logger);
+        uint32_t size = length - copied < sizeof(LogSlot) ? length - copied : sizeof(LogSlot);
 
-        printf("%s", log_line);
-        fprintf(token_file, "%s", log_line);
+        memcpy(slot->text, text + copied, size);
+        ring_publish(logger);
+        copied += size;
     }
 }
 
-void log_lexical_error(int line, char invalid_char)
+/**
+ * Registra um erro: pelo buffer, se houver uma thread de escrita, ou diretamente na saída padrão.
+ */
+static void log_error(Logger *logger, const LogEvent *event)
 {
-    if (token_file)
+    if (logger->active)
     {
-        char log_line[MAX_LOG_LINE];
-        snprintf(log_line, sizeof(log_line), "Lexical Error at line %02d: invalid character '%c' (ASCII code: %d)\n", line, invalid_char, invalid_char);
+        log_push(logger, event);
+        return;
+    }
+
+    log_write_diagnostic(logger->stdout_output, event);
+    output_flush(logger->stdout_output);
+}
+
+void log_token(CompilerContext *context, const Token *token)
+{
+    Logger *logger = &context->logger;
 
-        printf("%s", log_line);
+    if (token == NULL || !logger->active)
+    {
+        return;
     }
+
+    int line, column;
+    line_index_locate(logger->lines, token->offset, &line, &column);
+
+    // Como no scanner original, o comentário é registrado na linha em que termina
+    if (token->type == TOKEN_COMMENT)
+    {
+        line_index_locate(logger->lines, token->offset + token->length - 1, &line, NULL);
+    }
+
+    log_token_at(context, token, source_text(logger, token->offset), line, column);
 }
 
-void log_syntax_error(const Token *token)
+void log_token_at(CompilerContext *context, const Token *token, const char *text, int line, int column)
 {
-    if (token_file)
+    Logger *logger = &context->logger;
+
+    if (!logger->active)
     {
-        char log_line[MAX_LOG_LINE];
+        return;
+    }
+
+    // O log do comentário é limitado a MAX_COMMENT_LENGTH - 1 caracteres
+    uint32_t length = token->length;
+    if (token->type == TOKEN_COMMENT && length > MAX_COMMENT_LENGTH - 1)
+    {
+        length = MAX_COMMENT_LENGTH - 1;
+    }
 
-        if (token == NULL)
+    LogEvent event = {LOG_EVENT_TOKEN, token->type, token->kind, line, column, token->offset, token->length, text, length};
+    log_push(logger, &event);
+}
+
+void log_end_of_input(CompilerContext *context, uint32_t offset)
+{
+    Logger *logger = &context->logger;
+
+    if (logger->active)
+    {
+        LogEvent event = {LOG_EVENT_END_OF_INPUT, TOKEN_EOF, TOKEN_KIND_NONE, 0, 0, offset, 0, NULL, 0};
+        log_push(logger, &event);
+    }
+}
+
+void log_lexical_error(CompilerContext *context, uint32_t offset)
+{
+    Logger *logger = &context->logger;
+    int line, column;
+    line_index_locate(logger->lines, offset, &line, &column);
+
+    LogEvent event = {LOG_EVENT_LEXICAL_ERROR, TOKEN_EOF, TOKEN_KIND_NONE, line, column, offset, 1, source_text(logger, offset), 1};
+    log_error(logger, &event);
+}
+
+void log_syntax_error(CompilerContext *context, const Token *token)
+{
+    Logger *logger = &context->logger;
+
+    if (token == NULL || token->type == TOKEN_EOF)
+    {
+        LogEvent event = {LOG_EVENT_END_OF_FILE, TOKEN_EOF, TOKEN_KIND_NONE, 0, 0, 0, 0, NULL, 0};
+        log_error(logger, &event);
+    }
+    else
+    {
+        int line, column;
+        line_index_locate(logger->lines, token->offset, &line, &column);
+
+        log_syntax_error_at(context, token, line, column, source_text(logger, token->offset));
+    }
+}
+
+void log_syntax_error_at(CompilerContext *context, const Token *token, int line, int column, const char *text)
+{
+    LogEvent event = {LOG_EVENT_SYNTAX_ERROR, token->type, token->kind, line, column, token->offset, token->length, text, token->length};
+    log_error(&context->logger, &event);
+}
+
+void log_semantic_error(CompilerContext *context, uint32_t offset, uint32_t span, const char *message)
+{
+    int line, column;
+    line_index_locate(context->logger.lines, offset, &line, &column);
+
+    log_semantic_error_at(context, offset, span, line, column, message);
+}
+
+void log_semantic_error_at(CompilerContext *context, uint32_t offset, uint32_t span, int line, int column, const char *message)
+{
+    LogEvent event = {LOG_EVENT_SEMANTIC_ERROR, TOKEN_IDENTIFIER, TOKEN_KIND_NONE, line, column, offset, span, message, strlen(message)};
+    log_error(&context->logger, &event);
+}
+
+/* Consumidor */
+
+/**
+ * Espera o próximo registro ser publicado.
+ * @return false se o buffer foi fechado e não há mais registros.
+ */
+static bool ring_wait(Logger *logger, uint64_t tail)
+{
+    struct timespec pause = {0, 50000};
+
+    while (__atomic_load_n(&logger->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        if (__atomic_load_n(&logger->closing, __ATOMIC_ACQUIRE) && __atomic_load_n(&logger->head, __ATOMIC_ACQUIRE) == tail)
         {
-            snprintf(log_line, sizeof(log_line), "Syntax Error: Unexpected end of file\n");
+            return false;
         }
-        else
+
+        // Sem registros pendentes, o que já foi formatado é escrito antes de esperar
+        if (logger->file_output->length > 0 || logger->stdout_output->length > 0)
         {
-            snprintf(log_line, sizeof(log_line), "Syntax Error at line %02d: Unexpected token '%s' of type %s\n", token->line, token->value, token_type_to_string(token->type));
+            output_flush(logger->file_output);
+            output_flush(logger->stdout_output);
+            continue;
         }
 
-        printf("%s", log_line);
+        nanosleep(&pause, NULL);
     }
+
+    return true;
 }
 
-void log_cleanup()
+/**
+ * Consome o registro em tail, incluindo as continuações do texto.
+ * @return A posição do próximo registro.
+ */
+static uint64_t ring_read(Logger *logger, uint64_t tail, LogEvent *event)
 {
-    if (token_file)
+    LogRecord record = logger->ring[tail & (LOG_RING_SLOTS - 1)].record;
+    uint32_t copied = record.length < LOG_RECORD_TEXT ? record.length : LOG_RECORD_TEXT;
+
+    if (record.length > logger->event_text_capacity)
     {
-        fclose(token_file);
-        token_file = NULL;
+        free(logger->event_text);
+        logger->event_text_capacity = record.length * 2;
+        logger->event_text = (char *)checked_malloc(logger->event_text_capacity);
     }
-}
\ No newline at end of file
+
+    memcpy(logger->event_text, record.text, copied);
+    __atomic_store_n(&logger->tail, ++tail, __ATOMIC_RELEASE);
+
+    while (copied < record.length)
+    {
+        ring_wait(logger, tail);
+
+        uint32_t size = record.length - copied < sizeof(LogSlot) ? record.length - copied : sizeof(LogSlot);
+
+        memcpy(logger->event_text + copied, logger->ring[tail & (LOG_RING_SLOTS - 1)].text, size);
+        __atomic_store_n(&logger->tail, ++tail, __ATOMIC_RELEASE);
+        copied += size;
+    }
+
+    *event = (LogEvent){record.kind, record.type, record.token_kind, record.line, record.column, record.offset, record.span, logger->event_text, record.length};
+    return tail;
+}
+
+static void *log_writer(void *argument)
+{
+    Logger *logger = (Logger *)argument;
+    const LogSink *sink = logger->sink;
+    uint64_t tail = 0;
+    LogEvent event;
+
+    logger->event_text_capacity = MAX_LOG_LINE;
+    logger->event_text = (char *)checked_malloc(logger->event_text_capacity);
+
+    while (ring_wait(logger, tail))
+    {
+        tail = ring_read(logger, tail, &event);
+
+        if (event.kind != LOG_EVENT_TOKEN)
+        {
+            log_write_diagnostic(logger->stdout_output, &event);
+        }
+        else if (logger->echo)
+        {
+            sink->event(logger->stdout_output, &event);
+        }
+
+        sink->event(logger->file_output, &event);
+    }
+
+    if (sink->end != NULL)
+    {
+        sink->end(logger->file_output);
+    }
+
+    output_flush(logger->file_output);
+    output_flush(logger->stdout_output);
+
+    free(logger->event_text);
+    logger->event_text = NULL;
+    logger->event_text_capacity = 0;
+
+    return NULL;
+}
+
+void log_cleanup(CompilerContext *context)
+{
+    Logger *logger = &context->logger;
+
+    if (logger->active)
+    {
+        __atomic_store_n(&logger->closing, true, __ATOMIC_RELEASE);
+        pthread_join(logger->writer_thread, NULL);
+        logger->active = false;
+    }
+
+    // Depois de uma falha em log_init, o arquivo e os buffers podem existir sem a thread
+    if (logger->file != NULL)
+    {
+        fclose(logger->file);
+        logger->file = NULL;
+    }
+
+    free(logger->ring);
+    free(logger->file_output);
+    free(logger->stdout_output);
+    logger->ring = NULL;
+    logger->file_output = NULL;
+    logger->stdout_output = NULL;
+}
@@ -2,49 +2,161 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdbool.h>
 #include <string.h>
+#include <stdbool.h>
 
-#include "scanner.h"
-#include "logging.h"
+#include "allocation.h"
+#include "compiler_context.h"
 
-static Token *current_token = NULL;
+/**
+ * @brief Avança para o próximo token do fluxo. O token TOKEN_EOF final nunca é ultrapassado.
+ */
+static void token_advance(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
+
+    if (parser->current + 1 < parser->tokens.count)
+    {
+        parser->current++;
+    }
+    else if (parser->tokens.types[parser->current] != TOKEN_EOF)
+    {
+        // Só a leitura em fluxo chega aqui. O próximo lote pode descartar linhas do
+        // índice: os nós já criados são verificados antes, e as linhas do comando em
+        // análise, cujos nós ainda não foram criados, são mantidas
+        type_check_pending(context);
+        scanner_next_tokens(context, &parser->tokens, parser->statement_offset);
+        parser->current = 0;
+    }
+}
 
 /**
- * @brief Libera o espaço alocado para o token atual e obtém o próximo token do analisador léxico.
+ * @brief Registra um erro de sintaxe no token atual.
  */
-static void token_advance()
+static void token_report(CompilerContext *context)
 {
-    if (current_token)
+    Parser *parser = &context->parser;
+
+    Token token = token_stream_get(&parser->tokens, parser->current);
+    const TokenDumpRecord *record = parser->replay != NULL && token.type != TOKEN_EOF ? token_dump_find(parser->replay, token.offset) : NULL;
+
+    if (record != NULL)
+    {
+        log_syntax_error_at(context, &token, record->line, record->column, token_dump_string(parser->replay, record->string));
+    }
+    else
     {
-        free(current_token->value);
-        free(current_token);
+        log_syntax_error(context, &token);
     }
-    current_token = get_token();
 }
 
 /**
- * @brief Verifica se o token atual corresponde ao tipo e valor esperados.
+ * @brief Descarta tokens até um token de sincronização (; end begin procedure function) ou o fim do arquivo.
  */
-static bool token_check(TokenType type, const char *value)
+static void token_synchronize(CompilerContext *context)
 {
-    if (current_token == NULL)
-        return false;
+    Parser *parser = &context->parser;
 
-    if (current_token->type != type)
-        return false;
+    for (;;)
+    {
+        switch (parser->tokens.kinds[parser->current])
+        {
+        case DELIM_SEMI:
+        case KW_END:
+        case KW_BEGIN:
+        case KW_PROCEDURE:
+        case KW_FUNCTION:
+            return;
+
+        default:
+            break;
+        }
+
+        if (parser->tokens.types[parser->current] == TOKEN_EOF)
+            return;
+
+        token_advance(context);
+    }
+}
+
+/**
+ * @brief Conta um erro de sintaxe ou semântico no token em offset. Na reanálise incremental,
+ *        interrompe a análise sem registrar o erro; ao passar de max_errors erros, interrompe a compilação.
+ *        Os passos depois da análise registram erros fora da ordem do código-fonte, então
+ *        first_error_offset e last_error_offset guardam o menor e o maior offset.
+ */
+static void error_record(CompilerContext *context, uint32_t offset)
+{
+    Parser *parser = &context->parser;
+
+    if (parser->tentative)
+    {
+        compiler_fail(context);
+    }
+
+    if (parser->max_errors > 0 && parser->error_count == parser->max_errors)
+    {
+        // Os erros já registrados são escritos antes do aviso
+        log_cleanup(context);
+        fprintf(context->options.output, "Too many errors, stopping after %d\n", parser->max_errors);
+        compiler_fail(context);
+    }
+
+    if (parser->error_count == 0 || offset < parser->first_error_offset)
+    {
+        parser->first_error_offset = offset;
+    }
+
+    if (parser->error_count == 0 || offset > parser->last_error_offset)
+    {
+        parser->last_error_offset = offset;
+    }
+
+    parser->error_count++;
+}
+
+/**
+ * @brief Registra um erro de sintaxe no token atual e se recupera em modo pânico,
+ *        descartando tokens até o próximo token de sincronização. A análise continua
+ *        como se o que era esperado estivesse presente.
+ *
+ *        Enquanto nenhum token for consumido depois de uma recuperação, os erros
+ *        seguintes são consequência do primeiro e não são registrados. Ao passar de
+ *        max_errors erros, a compilação é interrompida.
+ */
+static void token_error(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
+
+    if (parser->error_count > 0 && parser->tokens.offsets[parser->current] == parser->recovery_offset)
+        return;
+
+    error_record(context, parser->tokens.offsets[parser->current]);
+    token_report(context);
+
+    token_synchronize(context);
+    parser->recovery_offset = parser->tokens.offsets[parser->current];
+}
+
+/**
+ * @brief Verifica se o token atual corresponde ao tipo e à categoria esperados.
+ *        TOKEN_KIND_NONE aceita qualquer token do tipo.
+ */
+static inline bool token_check(CompilerContext *context, TokenType type, TokenKind kind)
+{
+    Parser *parser = &context->parser;
 
-    return value == NULL || strcmp(current_token->value, value) == 0;
+    return parser->tokens.types[parser->current] == type && (kind == TOKEN_KIND_NONE || parser->tokens.kinds[parser->current] == kind);
 }
 
 /**
  * @brief Consome o token atual se ele corresponder ao tipo e valor esperados.
  */
-static bool token_match(TokenType type, const char *value)
+static bool token_match(CompilerContext *context, TokenType type, TokenKind kind)
 {
-    if (token_check(type, value))
+    if (token_check(context, type, kind))
     {
-        token_advance();
+        token_advance(context);
         return true;
     }
     return false;
@@ -53,185 +165,521 @@ static bool token_match(TokenType type, const char *value)
 /**
  * @brief Verifica se o token atual corresponde ao tipo e valor esperados.
  *        Se corresponder, avança para o próximo token.
- *        Caso contrário, registra um erro de sintaxe e termina o programa.
+ *        Caso contrário, registra um erro de sintaxe e se recupera.
  */
-static void token_expect(TokenType type, const char *value)
+static void token_expect(CompilerContext *context, TokenType type, TokenKind kind)
 {
-    if (!token_check(type, value))
+    if (!token_check(context, type, kind))
     {
-        log_syntax_error(current_token);
-        exit(EXIT_FAILURE);
+        token_error(context);
+        return;
     }
 
-    token_advance();
+    token_advance(context);
 }
 
-/* Números e identificadores */
+/**
+ * @brief O texto do token atual, no código-fonte ou na seção de strings do log reproduzido.
+ */
+static inline const char *token_text(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
+
+    return parser->replay != NULL ? token_dump_string(parser->replay, parser->tokens.symbols[parser->current]) : scanner_text(context, parser->tokens.offsets[parser->current]);
+}
 
-// <constant> ::= <integer constant> | <constant identifier>
-void parser_parse_constant()
+/**
+ * @brief Cria o nó da folha correspondente ao token atual (identificador, número ou booleano), sem consumi-lo.
+ */
+static AstIndex token_leaf(CompilerContext *context)
 {
-    if (token_match(TOKEN_NUMBER, NULL))
-        return;
+    Parser *parser = &context->parser;
 
-    if (token_match(TOKEN_IDENTIFIER, NULL))
-        return;
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstIndex index;
 
-    log_syntax_error(current_token);
-    exit(EXIT_FAILURE);
+    switch (parser->tokens.types[parser->current])
+    {
+    case TOKEN_IDENTIFIER:
+        index = ast_add(&parser->ast, AST_IDENTIFIER, TOKEN_KIND_NONE, offset);
+        ast_node(&parser->ast, index)->symbol = parser->tokens.symbols[parser->current];
+        break;
+
+    case TOKEN_NUMBER:
+    {
+        const char *text = token_text(context);
+        uint32_t value = 0;
+
+        // Aritmética de 32 bits sem sinal: constantes grandes são reduzidas módulo 2^32
+        for (uint32_t i = 0; i < parser->tokens.lengths[parser->current]; i++)
+        {
+            value = value * 10 + (uint32_t)(text[i] - '0');
+        }
+
+        index = ast_add(&parser->ast, AST_NUMBER, TOKEN_KIND_NONE, offset);
+        ast_node(&parser->ast, index)->value = value;
+        break;
+    }
+
+    default:
+        index = ast_add(&parser->ast, AST_BOOLEAN, parser->tokens.kinds[parser->current], offset);
+        break;
+    }
+
+    return index;
 }
 
-/* Expressões */
+/**
+ * @brief Registra um erro de sintaxe no token atual e cria um nó AST_ERROR no lugar do que era esperado.
+ */
+static AstIndex node_error(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
 
-// <variable> ::= <identifier>
-void parser_parse_variable()
+    AstIndex node = ast_add(&parser->ast, AST_ERROR, TOKEN_KIND_NONE, parser->tokens.offsets[parser->current]);
+    token_error(context);
+    return node;
+}
+
+/**
+ * @brief Consome um identificador e cria o seu nó.
+ *        Se o token atual não for um identificador, registra um erro de sintaxe e cria um nó AST_ERROR.
+ */
+static AstIndex token_expect_identifier(CompilerContext *context)
 {
-    token_expect(TOKEN_IDENTIFIER, NULL);
+    if (!token_check(context, TOKEN_IDENTIFIER, TOKEN_KIND_NONE))
+    {
+        return node_error(context);
+    }
+
+    AstIndex node = token_leaf(context);
+    token_advance(context);
+    return node;
 }
 
-// <multiplying operator> ::= * | div
-void parser_parse_multiplying_operator()
+static AstIndex node_unary(CompilerContext *context, TokenKind op, uint32_t offset, AstIndex operand)
 {
-    if (token_match(TOKEN_OPERATOR_ARITHMETIC, "*"))
-        return;
+    Parser *parser = &context->parser;
 
-    if (token_match(TOKEN_OPERATOR_ARITHMETIC, "div"))
-        return;
+    AstIndex index = ast_add(&parser->ast, AST_UNARY, op, offset);
+    ast_node(&parser->ast, index)->first = operand;
+    return index;
+}
+
+static AstIndex node_binary(CompilerContext *context, TokenKind op, uint32_t offset, AstIndex lhs, AstIndex rhs)
+{
+    Parser *parser = &context->parser;
 
-    log_syntax_error(current_token);
-    exit(EXIT_FAILURE);
+    AstIndex index = ast_add(&parser->ast, AST_BINARY, op, offset);
+    ast_node(&parser->ast, index)->first = lhs;
+    ast_node(&parser->ast, lhs)->next = rhs;
+    return index;
 }
 
-// <adding operator> ::= + | -
-void parser_parse_adding_operator()
+/* Escopos */
+
+void parser_semantic_error(CompilerContext *context, uint32_t offset, uint32_t span, const char *message)
 {
-    if (token_match(TOKEN_OPERATOR_ARITHMETIC, "+"))
-        return;
+    Parser *parser = &context->parser;
 
-    if (token_match(TOKEN_OPERATOR_ARITHMETIC, "-"))
-        return;
+    const TokenDumpRecord *record = parser->replay != NULL ? token_dump_find(parser->replay, offset) : NULL;
 
-    log_syntax_error(current_token);
-    exit(EXIT_FAILURE);
+    if (record != NULL)
+    {
+        parser_semantic_error_at(context, offset, span, record->line, record->column, message);
+    }
+    else
+    {
+        error_record(context, offset);
+        log_semantic_error(context, offset, span, message);
+    }
 }
 
-// <sign> ::= + | - | <empty>
-void parser_parse_sign()
+void parser_semantic_error_at(CompilerContext *context, uint32_t offset, uint32_t span, int line, int column, const char *message)
 {
-    if (token_match(TOKEN_OPERATOR_ARITHMETIC, "+"))
-        return;
+    error_record(context, offset);
+    log_semantic_error_at(context, offset, span, line, column, message);
+}
 
-    if (token_match(TOKEN_OPERATOR_ARITHMETIC, "-"))
-        return;
+const char *parser_symbol_name(CompilerContext *context, uint32_t symbol)
+{
+    Parser *parser = &context->parser;
+
+    return parser->replay != NULL ? token_dump_string(parser->replay, symbol) : symbol_table_name(&context->symbol_table, symbol);
 }
 
-// <relational operator> ::= = | <> | < | <= | >= | > | or | and
-void parser_parse_relational_operator()
+/**
+ * @brief Registra um erro semântico no identificador, com format aplicado ao seu nome.
+ */
+static void semantic_error(CompilerContext *context, AstIndex identifier, const char *format)
 {
-    if (token_match(TOKEN_OPERATOR_RELATIONAL, NULL))
-        return;
+    Parser *parser = &context->parser;
 
-    if (token_match(TOKEN_KEYWORD, "or"))
-        return;
+    const char *name = parser_symbol_name(context, ast_node(&parser->ast, identifier)->symbol);
+    char message[MAX_LOG_LINE];
 
-    if (token_match(TOKEN_KEYWORD, "and"))
-        return;
+    snprintf(message, sizeof(message), format, name);
+    parser_semantic_error(context, ast_node(&parser->ast, identifier)->offset, strlen(name), message);
+}
+
+/**
+ * @brief Declara o identificador no escopo atual. Nós AST_ERROR no lugar do nome são ignorados.
+ * @return NULL, ou a declaração anterior do mesmo nome no escopo atual, que continua valendo.
+ */
+static const ScopeEntry *scope_add(CompilerContext *context, AstIndex identifier, AstKind kind, TokenKind type, uint16_t flags)
+{
+    Parser *parser = &context->parser;
+
+    const AstNode *node = ast_node(&parser->ast, identifier);
 
-    log_syntax_error(current_token);
-    exit(EXIT_FAILURE);
+    if (node->kind != AST_IDENTIFIER)
+    {
+        return NULL;
+    }
+
+    ScopeEntry entry = {node->symbol, identifier, kind, type, flags};
+    return scope_declare(&parser->scopes, &entry);
 }
 
-// <factor> ::= <variable> | <constant> | ( <expression> ) | not <factor> | bool
-void parser_parse_factor()
+/**
+ * @brief Declara o nome de uma variável, parâmetro ou subrotina no escopo atual.
+ *        Um nome já declarado no mesmo escopo é um erro; nomes de escopos de fora são ocultados.
+ */
+static void declare_identifier(CompilerContext *context, AstIndex identifier, AstKind kind, TokenKind type, uint16_t flags)
 {
-    if (token_match(TOKEN_DELIMITER, "("))
+    if (scope_add(context, identifier, kind, type, flags) != NULL)
     {
-        parser_parse_expression();
-        token_expect(TOKEN_DELIMITER, ")");
-        return;
+        semantic_error(context, identifier, "Identifier '%s' already declared in this scope");
     }
+}
 
-    if (token_match(TOKEN_KEYWORD, "not"))
+/**
+ * @brief Declara os nomes de uma AST_VAR_DECLARATION no escopo atual.
+ */
+static void declare_variables(CompilerContext *context, AstIndex declaration)
+{
+    Parser *parser = &context->parser;
+
+    const AstNode *node = ast_node(&parser->ast, declaration);
+    TokenKind type = node->op;
+    uint16_t flags = node->flags;
+
+    for (AstIndex name = node->first; name != AST_NONE; name = ast_node(&parser->ast, name)->next)
     {
-        parser_parse_factor();
-        return;
+        declare_identifier(context, name, AST_VAR_DECLARATION, type, flags);
     }
+}
+
+/**
+ * @brief Liga o uso de um identificador à declaração visível mais interna: o tipo
+ *        declarado vai para op, e AST_FLAG_VARIABLE ou AST_FLAG_SUBROUTINE para flags.
+ *        Um nome sem declaração visível é um erro. Outros nós são ignorados.
+ */
+static void resolve_identifier(CompilerContext *context, AstIndex identifier)
+{
+    Parser *parser = &context->parser;
 
-    if (token_check(TOKEN_BOOLEAN, NULL))
+    AstNode *node = ast_node(&parser->ast, identifier);
+
+    if (node->kind != AST_IDENTIFIER)
     {
-        token_advance();
         return;
     }
 
-    if (token_check(TOKEN_IDENTIFIER, NULL))
+    const ScopeEntry *entry = scope_lookup(&parser->scopes, node->symbol);
+
+    if (entry == NULL)
     {
-        parser_parse_variable();
+        semantic_error(context, identifier, "Identifier '%s' not declared");
         return;
     }
 
-    parser_parse_constant();
+    node->op = entry->type;
+    node->flags |= entry->kind == AST_VAR_DECLARATION ? AST_FLAG_VARIABLE : AST_FLAG_SUBROUTINE;
 }
 
-// <term> ::= <factor> { <multiplying operator> <factor> }
-void parser_parse_term()
+/* Expressões */
+
+// <variable> ::= <identifier>
+AstIndex parser_parse_variable(CompilerContext *context)
 {
-    parser_parse_factor();
+    if (!token_check(context, TOKEN_IDENTIFIER, TOKEN_KIND_NONE))
+    {
+        return node_error(context);
+    }
+
+    // Resolvida antes de avançar, que pode verificar os tipos dos nós já criados
+    AstIndex variable = token_leaf(context);
+    resolve_identifier(context, variable);
+    token_advance(context);
+    return variable;
+}
+
+/*
+As expressões são analisadas por precedência de operadores (Pratt), com pilhas
+explícitas de operandos e de operadores pendentes em vez de uma função por
+nível da gramática. Cada operando custa só a criação do nó e o avanço do
+token, e o aninhamento de parênteses não tem limite de profundidade.
+*/
+
+// Precedência dos operadores, da menor para a maior
+enum
+{
+    PRECEDENCE_NONE,
+    PRECEDENCE_RELATIONAL,  // = <> < <= > >=, no máximo um por <expression>
+    PRECEDENCE_ADDING,      // + - or
+    PRECEDENCE_SIGN,        // <sign>, aplicado ao primeiro <term> de uma <simple expression>
+    PRECEDENCE_MULTIPLYING, // * div and
+    PRECEDENCE_NOT,         // not <factor>
+};
+
+static const uint8_t binary_precedences[TOKEN_KIND_COUNT] = {
+    [OP_TIMES] = PRECEDENCE_MULTIPLYING,
+    [OP_DIV] = PRECEDENCE_MULTIPLYING,
+    [OP_PLUS] = PRECEDENCE_ADDING,
+    [OP_MINUS] = PRECEDENCE_ADDING,
+    [OP_AND] = PRECEDENCE_MULTIPLYING,
+    [OP_OR] = PRECEDENCE_ADDING,
+    [REL_EQ] = PRECEDENCE_RELATIONAL,
+    [REL_NE] = PRECEDENCE_RELATIONAL,
+    [REL_LT] = PRECEDENCE_RELATIONAL,
+    [REL_LE] = PRECEDENCE_RELATIONAL,
+    [REL_GT] = PRECEDENCE_RELATIONAL,
+    [REL_GE] = PRECEDENCE_RELATIONAL,
+};
+
+static void operator_push(CompilerContext *context, PendingKind kind, int precedence, TokenKind op, bool relational, uint32_t offset)
+{
+    Parser *parser = &context->parser;
+
+    if (parser->operator_count == parser->operator_capacity)
+    {
+        parser->operator_capacity = parser->operator_capacity ? parser->operator_capacity * 2 : 64;
+        parser->operators = (PendingOperator *)checked_realloc(parser->operators, parser->operator_capacity * sizeof(PendingOperator), "Error allocating expression stack");
+    }
+
+    parser->operators[parser->operator_count++] = (PendingOperator){kind, precedence, op, relational, offset};
+}
+
+static void operand_push(CompilerContext *context, AstIndex operand)
+{
+    Parser *parser = &context->parser;
 
-    while (token_check(TOKEN_OPERATOR_ARITHMETIC, "*") || token_check(TOKEN_OPERATOR_ARITHMETIC, "div"))
+    if (parser->operand_count == parser->operand_capacity)
     {
-        parser_parse_multiplying_operator();
-        parser_parse_factor();
+        parser->operand_capacity = parser->operand_capacity ? parser->operand_capacity * 2 : 64;
+        parser->operands = (AstIndex *)checked_realloc(parser->operands, parser->operand_capacity * sizeof(AstIndex), "Error allocating expression stack");
     }
+
+    parser->operands[parser->operand_count++] = operand;
 }
 
-// <simple expression> ::= <sign> <term> { <adding operator> <term> }
-void parser_parse_simple_expression()
+/**
+ * @brief Aplica os operadores pendentes de precedência maior ou igual a precedence,
+ *        até o parêntese aberto mais recente.
+ */
+static void operator_reduce(CompilerContext *context, uint32_t base, int precedence)
 {
-    parser_parse_sign();
-    parser_parse_term();
+    Parser *parser = &context->parser;
 
-    while (token_check(TOKEN_OPERATOR_ARITHMETIC, "+") || token_check(TOKEN_OPERATOR_ARITHMETIC, "-"))
+    while (parser->operator_count > base && parser->operators[parser->operator_count - 1].kind != PENDING_PARENTHESIS &&
+           parser->operators[parser->operator_count - 1].precedence >= precedence)
     {
-        parser_parse_adding_operator();
-        parser_parse_term();
+        PendingOperator pending = parser->operators[--parser->operator_count];
+        AstIndex operand = parser->operands[--parser->operand_count];
+
+        if (pending.kind == PENDING_UNARY)
+        {
+            operand = node_unary(context, pending.op, pending.offset, operand);
+        }
+        else
+        {
+            AstIndex lhs = parser->operands[--parser->operand_count];
+            operand = node_binary(context, pending.op, pending.offset, lhs, operand);
+        }
+
+        parser->operands[parser->operand_count++] = operand;
     }
 }
 
-// <expression> ::= <simple expression> | <simple expression> <relational operator> <simple expression>
-void parser_parse_expression()
+/**
+ * @return A precedência do operador binário no token atual, ou PRECEDENCE_NONE.
+ */
+static inline int token_precedence(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
+
+    TokenKind kind = parser->tokens.kinds[parser->current];
+    return kind == TOKEN_KIND_NONE ? PRECEDENCE_NONE : binary_precedences[kind];
+}
+
+/*
+<expression> ::= <simple expression> | <simple expression> <relational operator> <simple expression>
+<simple expression> ::= <sign> <term> { <adding operator> <term> }
+<term> ::= <factor> { <multiplying operator> <factor> }
+<factor> ::= <variable> | <constant> | ( <expression> ) | not <factor> | bool
+
+<relational operator> ::= = | <> | < | <= | >= | >
+<adding operator> ::= + | - | or
+<multiplying operator> ::= * | div | and
+<sign> ::= + | - | <empty>
+<constant> ::= <integer constant> | <constant identifier>
+*/
+AstIndex parser_parse_expression(CompilerContext *context)
 {
-    parser_parse_simple_expression();
+    Parser *parser = &context->parser;
 
-    if (token_check(TOKEN_OPERATOR_RELATIONAL, NULL))
+    uint32_t operator_base = parser->operator_count;
+    bool simple_start = true; // O operando inicia uma <simple expression> e pode ter <sign>
+    bool relational = false;  // A <expression> atual já tem um operador relacional
+
+    for (;;)
     {
-        parser_parse_relational_operator();
-        parser_parse_simple_expression();
+        // Operando, precedido pelos operadores prefixos
+
+        TokenKind kind = parser->tokens.kinds[parser->current];
+
+        if (simple_start && (kind == OP_PLUS || kind == OP_MINUS))
+        {
+            operator_push(context, PENDING_UNARY, PRECEDENCE_SIGN, kind, false, parser->tokens.offsets[parser->current]);
+            token_advance(context);
+        }
+
+        simple_start = false;
+
+        while (token_check(context, TOKEN_OPERATOR_LOGICAL, OP_NOT))
+        {
+            operator_push(context, PENDING_UNARY, PRECEDENCE_NOT, OP_NOT, false, parser->tokens.offsets[parser->current]);
+            token_advance(context);
+        }
+
+        if (token_check(context, TOKEN_DELIMITER, DELIM_LPAREN))
+        {
+            operator_push(context, PENDING_PARENTHESIS, PRECEDENCE_NONE, DELIM_LPAREN, relational, parser->tokens.offsets[parser->current]);
+            token_advance(context);
+            simple_start = true;
+            relational = false;
+            continue;
+        }
+
+        if (token_check(context, TOKEN_BOOLEAN, TOKEN_KIND_NONE) || token_check(context, TOKEN_IDENTIFIER, TOKEN_KIND_NONE) || token_check(context, TOKEN_NUMBER, TOKEN_KIND_NONE))
+        {
+            AstIndex operand = token_leaf(context);
+            resolve_identifier(context, operand);
+            operand_push(context, operand);
+            token_advance(context);
+        }
+        else
+        {
+            operand_push(context, node_error(context));
+        }
+
+        // Operador binário, ou o fim de uma expressão entre parênteses ou da expressão inteira
+
+        for (;;)
+        {
+            int precedence = token_precedence(context);
+
+            // Um segundo operador relacional termina a <expression>, como na gramática
+            if (precedence == PRECEDENCE_RELATIONAL && relational)
+            {
+                precedence = PRECEDENCE_NONE;
+            }
+
+            operator_reduce(context, operator_base, precedence);
+
+            if (precedence != PRECEDENCE_NONE)
+            {
+                operator_push(context, PENDING_BINARY, precedence, parser->tokens.kinds[parser->current], false, parser->tokens.offsets[parser->current]);
+                token_advance(context);
+
+                if (precedence == PRECEDENCE_RELATIONAL)
+                {
+                    relational = true;
+                    simple_start = true;
+                }
+                break;
+            }
+
+            if (parser->operator_count == operator_base)
+            {
+                return parser->operands[--parser->operand_count];
+            }
+
+            // O topo da pilha é o parêntese aberto, e o seu conteúdo passa a ser um operando
+            relational = parser->operators[--parser->operator_count].relational;
+            token_expect(context, TOKEN_DELIMITER, DELIM_RPAREN);
+        }
     }
 }
 
 /* Comandos */
 
+/**
+ * @brief Na leitura em fluxo, mantém no índice de linhas as linhas a partir de offset,
+ *        o início do comando ou da condição em análise, até type_check_pending verificar
+ *        os seus nós, que só são criados no fim.
+ */
+static inline void statement_begin(CompilerContext *context, uint32_t offset)
+{
+    context->parser.statement_offset = offset;
+}
+
+static inline void statement_end(CompilerContext *context)
+{
+    context->parser.statement_offset = UINT32_MAX;
+}
+
 // <while statement> ::= while <expression> do <statement>
-void parser_parse_while_statement()
+AstIndex parser_parse_while_statement(CompilerContext *context)
 {
-    token_expect(TOKEN_KEYWORD, "while");
-    parser_parse_expression();
-    token_expect(TOKEN_KEYWORD, "do");
-    parser_parse_statement();
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
+
+    statement_begin(context, offset);
+    token_expect(context, TOKEN_KEYWORD, KW_WHILE);
+    ast_list_append(&parser->ast, &children, parser_parse_expression(context));
+
+    // O nó só é criado depois do comando, quando a linha do while pode ter saído do índice
+    TypePosition keyword = type_position_at(context, offset);
+    statement_end(context);
+
+    token_expect(context, TOKEN_KEYWORD, KW_DO);
+    ast_list_append(&parser->ast, &children, parser_parse_statement(context));
+
+    AstIndex node = ast_add_list(&parser->ast, AST_WHILE, TOKEN_KIND_NONE, offset, &children);
+    type_position_keep(context, node, keyword);
+    return node;
 }
 
 // <if statement> ::= if <expression> then <statement> { else <statement> }
-void parser_parse_if_statement()
+AstIndex parser_parse_if_statement(CompilerContext *context)
 {
-    token_expect(TOKEN_KEYWORD, "if");
-    parser_parse_expression();
-    token_expect(TOKEN_KEYWORD, "then");
-    parser_parse_statement();
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
+
+    statement_begin(context, offset);
+    token_expect(context, TOKEN_KEYWORD, KW_IF);
+    ast_list_append(&parser->ast, &children, parser_parse_expression(context));
+
+    TypePosition keyword = type_position_at(context, offset);
+    statement_end(context);
 
-    if (token_match(TOKEN_KEYWORD, "else"))
+    token_expect(context, TOKEN_KEYWORD, KW_THEN);
+    ast_list_append(&parser->ast, &children, parser_parse_statement(context));
+
+    if (token_match(context, TOKEN_KEYWORD, KW_ELSE))
     {
-        parser_parse_statement();
+        ast_list_append(&parser->ast, &children, parser_parse_statement(context));
     }
+
+    AstIndex node = ast_add_list(&parser->ast, AST_IF, TOKEN_KIND_NONE, offset, &children);
+    type_position_keep(context, node, keyword);
+    return node;
 }
 
 /*
@@ -241,56 +689,61 @@ read ( <variable> { , <variable> } )
 <write statement> ::=
 write ( <variable> { , <variable> } )
 */
-void parser_parse_read_write_statement()
+AstIndex parser_parse_read_write_statement(CompilerContext *context)
 {
-    bool result = token_match(TOKEN_KEYWORD, "write") || token_match(TOKEN_KEYWORD, "read");
+    Parser *parser = &context->parser;
 
-    if (!result)
-    {
-        log_syntax_error(current_token);
-        exit(EXIT_FAILURE);
-    }
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList variables = {AST_NONE, AST_NONE};
 
-    token_expect(TOKEN_DELIMITER, "(");
+    // read não é uma palavra reservada: só write chega aqui como TOKEN_KEYWORD
+    statement_begin(context, offset);
+    token_expect(context, TOKEN_KEYWORD, KW_WRITE);
+    token_expect(context, TOKEN_DELIMITER, DELIM_LPAREN);
 
-    parser_parse_variable();
+    ast_list_append(&parser->ast, &variables, parser_parse_variable(context));
 
-    while (token_match(TOKEN_DELIMITER, ","))
+    while (token_match(context, TOKEN_DELIMITER, DELIM_COMMA))
     {
-        parser_parse_variable();
+        ast_list_append(&parser->ast, &variables, parser_parse_variable(context));
     }
 
-    token_expect(TOKEN_DELIMITER, ")");
+    token_expect(context, TOKEN_DELIMITER, DELIM_RPAREN);
+    statement_end(context);
+
+    return ast_add_list(&parser->ast, AST_WRITE, TOKEN_KIND_NONE, offset, &variables);
 }
 
-// <parameters list> ::= ( <identifier> | <number> | <bool> ) {, ( <identifier> | <numero> | <bool> ) }
-void parser_parse_parameters_list()
+/**
+ * @brief Um argumento de <parameters list>: identificador, número ou booleano.
+ */
+static AstIndex parser_parse_argument(CompilerContext *context)
 {
-    token_expect(TOKEN_DELIMITER, "(");
-
-    bool result = token_match(TOKEN_IDENTIFIER, NULL) || token_match(TOKEN_NUMBER, NULL) || token_match(TOKEN_BOOLEAN, NULL);
-
-    if (!result)
+    if (token_check(context, TOKEN_IDENTIFIER, TOKEN_KIND_NONE) || token_check(context, TOKEN_NUMBER, TOKEN_KIND_NONE) || token_check(context, TOKEN_BOOLEAN, TOKEN_KIND_NONE))
     {
-        log_syntax_error(current_token);
-        exit(EXIT_FAILURE);
+        AstIndex node = token_leaf(context);
+        resolve_identifier(context, node);
+        token_advance(context);
+        return node;
     }
 
-    token_expect(TOKEN_DELIMITER, ")");
-
-    while (token_match(TOKEN_DELIMITER, ","))
-    {
-        token_expect(TOKEN_DELIMITER, "(");
+    return node_error(context);
+}
 
-        bool result = token_match(TOKEN_IDENTIFIER, NULL) || token_match(TOKEN_NUMBER, NULL) || token_match(TOKEN_BOOLEAN, NULL);
+// <parameters list> ::= ( <identifier> | <number> | <bool> ) {, ( <identifier> | <numero> | <bool> ) }
+void parser_parse_parameters_list(CompilerContext *context, AstList *arguments)
+{
+    Parser *parser = &context->parser;
 
-        if (!result)
-        {
-            log_syntax_error(current_token);
-            exit(EXIT_FAILURE);
-        }
+    token_expect(context, TOKEN_DELIMITER, DELIM_LPAREN);
+    ast_list_append(&parser->ast, arguments, parser_parse_argument(context));
+    token_expect(context, TOKEN_DELIMITER, DELIM_RPAREN);
 
-        token_expect(TOKEN_DELIMITER, ")");
+    while (token_match(context, TOKEN_DELIMITER, DELIM_COMMA))
+    {
+        token_expect(context, TOKEN_DELIMITER, DELIM_LPAREN);
+        ast_list_append(&parser->ast, arguments, parser_parse_argument(context));
+        token_expect(context, TOKEN_DELIMITER, DELIM_RPAREN);
     }
 }
 
@@ -298,36 +751,56 @@ void parser_parse_parameters_list()
 <function_procedure statement> ::=
 <function_procedure identifier> ( <parameters list> ) | <variable> := <function_procedure identifier> ( <parameters list>)
 */
-void parser_parse_function_procedure_statement()
+AstIndex parser_parse_function_procedure_statement(CompilerContext *context)
 {
-    if (token_match(TOKEN_IDENTIFIER, NULL))
+    Parser *parser = &context->parser;
+
+    AstList call = {AST_NONE, AST_NONE};
+    uint32_t offset = parser->tokens.offsets[parser->current];
+
+    statement_begin(context, offset);
+    AstIndex name = parser_parse_variable(context);
+
+    if (token_match(context, TOKEN_OPERATOR_ASSIGNMENT, TOKEN_KIND_NONE))
     {
-        if (token_match(TOKEN_OPERATOR_ASSIGNMENT, NULL))
-        {
-            // <variable> := <function_procedure identifier> ( <parameters list>)
+        // <variable> := <function_procedure identifier> ( <parameters list>)
 
-            token_expect(TOKEN_IDENTIFIER, NULL);
-            parser_parse_parameters_list();
-            return;
-        }
+        AstList assignment = {AST_NONE, AST_NONE};
+        uint32_t call_offset = parser->tokens.offsets[parser->current];
 
-        // <function_procedure identifier> ( <parameters list> )
+        ast_list_append(&parser->ast, &call, parser_parse_variable(context));
+        parser_parse_parameters_list(context, &call);
+        statement_end(context);
 
-        token_expect(TOKEN_IDENTIFIER, NULL);
-        parser_parse_parameters_list();
-        return;
+        ast_list_append(&parser->ast, &assignment, name);
+        ast_list_append(&parser->ast, &assignment, ast_add_list(&parser->ast, AST_CALL, TOKEN_KIND_NONE, call_offset, &call));
+        return ast_add_list(&parser->ast, AST_ASSIGNMENT, TOKEN_KIND_NONE, offset, &assignment);
     }
 
-    log_syntax_error(current_token);
-    exit(EXIT_FAILURE);
+    // <function_procedure identifier> ( <parameters list> )
+
+    ast_list_append(&parser->ast, &call, name);
+    parser_parse_parameters_list(context, &call);
+    statement_end(context);
+
+    return ast_add_list(&parser->ast, AST_CALL, TOKEN_KIND_NONE, offset, &call);
 }
 
 // <assignment statement> ::= <variable> := <expression>
-void parser_parse_assignment_statement()
+AstIndex parser_parse_assignment_statement(CompilerContext *context)
 {
-    token_expect(TOKEN_IDENTIFIER, NULL);
-    token_expect(TOKEN_OPERATOR_ASSIGNMENT, NULL);
-    parser_parse_expression();
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
+
+    statement_begin(context, offset);
+    ast_list_append(&parser->ast, &children, parser_parse_variable(context));
+    token_expect(context, TOKEN_OPERATOR_ASSIGNMENT, TOKEN_KIND_NONE);
+    ast_list_append(&parser->ast, &children, parser_parse_expression(context));
+    statement_end(context);
+
+    return ast_add_list(&parser->ast, AST_ASSIGNMENT, TOKEN_KIND_NONE, offset, &children);
 }
 
 /*
@@ -340,200 +813,669 @@ void parser_parse_assignment_statement()
 | <if statement>
 | <while statement>
 */
-void parser_parse_statement()
+AstIndex parser_parse_statement(CompilerContext *context)
 {
-    if (token_check(TOKEN_KEYWORD, "read") || token_check(TOKEN_KEYWORD, "write"))
-    {
-        parser_parse_read_write_statement();
-        return;
-    }
+    Parser *parser = &context->parser;
 
-    if (token_check(TOKEN_KEYWORD, "if"))
+    switch (parser->tokens.kinds[parser->current])
     {
-        parser_parse_if_statement();
-        return;
-    }
+    case KW_WRITE:
+        return parser_parse_read_write_statement(context);
 
-    if (token_check(TOKEN_KEYWORD, "begin"))
-    {
-        parser_parse_compound_statement();
-        return;
-    }
+    case KW_IF:
+        return parser_parse_if_statement(context);
 
-    if (token_check(TOKEN_KEYWORD, "while"))
-    {
-        parser_parse_while_statement();
-        return;
+    case KW_BEGIN:
+        return parser_parse_compound_statement(context);
+
+    case KW_WHILE:
+        return parser_parse_while_statement(context);
+
+    default:
+        break;
     }
 
-    if (token_check(TOKEN_IDENTIFIER, NULL))
+    if (token_check(context, TOKEN_IDENTIFIER, TOKEN_KIND_NONE))
     {
-        parser_parse_assignment_statement();
         // FIXME <function_procedure statement> removido por enquanto
-        return;
+        return parser_parse_assignment_statement(context);
     }
+
+    return ast_add(&parser->ast, AST_EMPTY, TOKEN_KIND_NONE, parser->tokens.offsets[parser->current]);
 }
 
 // <compound_statement> ::= begin <statement> { ; <statement> } end
-void parser_parse_compound_statement()
+AstIndex parser_parse_compound_statement(CompilerContext *context)
 {
-    token_expect(TOKEN_KEYWORD, "begin");
-    parser_parse_statement();
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList statements = {AST_NONE, AST_NONE};
 
-    while (token_match(TOKEN_DELIMITER, ";"))
+    token_expect(context, TOKEN_KEYWORD, KW_BEGIN);
+    ast_list_append(&parser->ast, &statements, parser_parse_statement(context));
+
+    while (!token_check(context, TOKEN_KEYWORD, KW_END))
     {
-        parser_parse_statement();
+        if (!token_match(context, TOKEN_DELIMITER, DELIM_SEMI))
+        {
+            // Comando mal formado ou sem ";": continua no próximo comando, se a recuperação parar em um
+            token_error(context);
+
+            if (!token_match(context, TOKEN_DELIMITER, DELIM_SEMI) && !token_check(context, TOKEN_KEYWORD, KW_BEGIN))
+                break;
+        }
+
+        ast_list_append(&parser->ast, &statements, parser_parse_statement(context));
     }
 
-    token_expect(TOKEN_KEYWORD, "end");
+    token_expect(context, TOKEN_KEYWORD, KW_END);
+
+    return ast_add_list(&parser->ast, AST_COMPOUND, TOKEN_KIND_NONE, offset, &statements);
 }
 
 /* Declarações */
 
+/**
+ * @brief Uma <variable declaration> de parâmetros formais.
+ */
+static AstIndex parser_parse_parameter_declaration(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
+
+    AstIndex declaration = parser_parse_variable_declaration(context);
+    ast_node(&parser->ast, declaration)->flags |= AST_FLAG_PARAMETER;
+    return declaration;
+}
+
 // <formal parameters> ::= <empty> | var <variable declaration> { ; var <variable declaration> }
-void parser_parse_formal_parameters()
+void parser_parse_formal_parameters(CompilerContext *context, AstList *parameters)
 {
-    if (token_match(TOKEN_KEYWORD, "var"))
+    Parser *parser = &context->parser;
+
+    if (token_match(context, TOKEN_KEYWORD, KW_VAR))
     {
-        parser_parse_variable_declaration();
+        ast_list_append(&parser->ast, parameters, parser_parse_parameter_declaration(context));
 
-        while (token_match(TOKEN_DELIMITER, ";"))
+        while (token_match(context, TOKEN_DELIMITER, DELIM_SEMI))
         {
-            token_expect(TOKEN_KEYWORD, "var");
-            parser_parse_variable_declaration();
+            token_expect(context, TOKEN_KEYWORD, KW_VAR);
+            ast_list_append(&parser->ast, parameters, parser_parse_parameter_declaration(context));
         }
     }
 }
 
 // <function declaration> ::= function < identifier > ( < formal parameters > ) : < type > ; < block > ;
-void parser_parse_function_declaration()
+AstIndex parser_parse_function_declaration(CompilerContext *context)
 {
-    token_expect(TOKEN_KEYWORD, "function");
-    token_expect(TOKEN_IDENTIFIER, NULL);
-    token_expect(TOKEN_DELIMITER,"(");
-    parser_parse_formal_parameters();
-    token_expect(TOKEN_DELIMITER,")");
-    token_expect(TOKEN_DELIMITER, ":");
-    parser_parse_type();
-    token_expect(TOKEN_DELIMITER, ";");
-    parser_parse_block();
-    token_expect(TOKEN_DELIMITER, ";");
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
+
+    token_expect(context, TOKEN_KEYWORD, KW_FUNCTION);
+    AstIndex name = token_expect_identifier(context);
+    ast_list_append(&parser->ast, &children, name);
+    token_expect(context, TOKEN_DELIMITER, DELIM_LPAREN);
+    parser_parse_formal_parameters(context, &children);
+    token_expect(context, TOKEN_DELIMITER, DELIM_RPAREN);
+    token_expect(context, TOKEN_DELIMITER, DELIM_COLON);
+    TokenKind type = parser_parse_type(context);
+    token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
+
+    // O nome é visível no próprio bloco, para chamadas recursivas e para a atribuição do resultado
+    declare_identifier(context, name, AST_FUNCTION, type, 0);
+    ast_list_append(&parser->ast, &children, parser_parse_block(context, ast_node(&parser->ast, name)->next));
+    token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
+
+    return ast_add_list(&parser->ast, AST_FUNCTION, type, offset, &children);
 }
 
 // <procedure declaration> ::= procedure < identifier > ( < formal parameters > ) ; <block> ;
-void parser_parse_procedure_declaration()
+AstIndex parser_parse_procedure_declaration(CompilerContext *context)
 {
-    token_expect(TOKEN_KEYWORD, "procedure");
-    token_expect(TOKEN_IDENTIFIER, NULL);
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
 
-    if (token_match(TOKEN_DELIMITER, "("))
+    token_expect(context, TOKEN_KEYWORD, KW_PROCEDURE);
+    AstIndex name = token_expect_identifier(context);
+    ast_list_append(&parser->ast, &children, name);
+
+    if (token_match(context, TOKEN_DELIMITER, DELIM_LPAREN))
     {
-        parser_parse_formal_parameters();
-        token_expect(TOKEN_DELIMITER, ")");
+        parser_parse_formal_parameters(context, &children);
+        token_expect(context, TOKEN_DELIMITER, DELIM_RPAREN);
     }
 
-    token_expect(TOKEN_DELIMITER, ";");
-    parser_parse_block();
-    token_expect(TOKEN_DELIMITER, ";");
+    token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
+
+    declare_identifier(context, name, AST_PROCEDURE, TOKEN_KIND_NONE, 0);
+    ast_list_append(&parser->ast, &children, parser_parse_block(context, ast_node(&parser->ast, name)->next));
+    token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
+
+    return ast_add_list(&parser->ast, AST_PROCEDURE, TOKEN_KIND_NONE, offset, &children);
 }
 
 // <subroutine declaration part> ::= <empty> | < procedure declaration | function declaration >
-void parser_parse_subroutine_declaration_part()
+void parser_parse_subroutine_declaration_part(CompilerContext *context, AstList *subroutines)
 {
-    while (token_check(TOKEN_KEYWORD, "procedure") || token_check(TOKEN_KEYWORD, "function"))
+    Parser *parser = &context->parser;
+
+    for (;;)
     {
-        if (token_check(TOKEN_KEYWORD, "procedure"))
-        {
-            parser_parse_procedure_declaration();
-        }
-        else if (token_check(TOKEN_KEYWORD, "function"))
+        switch (parser->tokens.kinds[parser->current])
         {
-            parser_parse_function_declaration();
+        case KW_PROCEDURE:
+            ast_list_append(&parser->ast, subroutines, parser_parse_procedure_declaration(context));
+            break;
+
+        case KW_FUNCTION:
+            ast_list_append(&parser->ast, subroutines, parser_parse_function_declaration(context));
+            break;
+
+        default:
+            return;
         }
     }
 }
 
 // <type> ::= integer | boolean
-void parser_parse_type()
+TokenKind parser_parse_type(CompilerContext *context)
 {
-    if (!token_check(TOKEN_KEYWORD, "integer") && !token_check(TOKEN_KEYWORD, "boolean"))
+    Parser *parser = &context->parser;
+
+    TokenKind type = parser->tokens.kinds[parser->current];
+
+    switch (type)
     {
-        log_syntax_error(current_token);
-        exit(EXIT_FAILURE);
+    case KW_INTEGER:
+    case KW_BOOLEAN:
+        token_advance(context);
+        return type;
+
+    default:
+        token_error(context);
+        return TOKEN_KIND_NONE;
     }
-    token_advance();
 }
 
 // <variable declaration> ::= <identifier > { , <identifier> } : <type>
-void parser_parse_variable_declaration()
+AstIndex parser_parse_variable_declaration(CompilerContext *context)
 {
-    token_expect(TOKEN_IDENTIFIER, NULL);
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList names = {AST_NONE, AST_NONE};
 
-    while (token_match(TOKEN_DELIMITER, ","))
+    ast_list_append(&parser->ast, &names, token_expect_identifier(context));
+
+    while (token_match(context, TOKEN_DELIMITER, DELIM_COMMA))
     {
-        token_expect(TOKEN_IDENTIFIER, NULL);
+        ast_list_append(&parser->ast, &names, token_expect_identifier(context));
     }
 
-    token_expect(TOKEN_DELIMITER, ":");
+    token_expect(context, TOKEN_DELIMITER, DELIM_COLON);
+
+    TokenKind type = parser_parse_type(context);
 
-    parser_parse_type();
+    return ast_add_list(&parser->ast, AST_VAR_DECLARATION, type, offset, &names);
 }
 
 // <variable declaration part> ::= <empty> | var <variable declaration> ; { <variable declaration part> ; }
-void parser_parse_variable_declaration_part()
+void parser_parse_variable_declaration_part(CompilerContext *context, AstList *declarations)
 {
-    if (token_match(TOKEN_KEYWORD, "var"))
+    Parser *parser = &context->parser;
+
+    if (token_match(context, TOKEN_KEYWORD, KW_VAR))
     {
-        parser_parse_variable_declaration();
-        token_expect(TOKEN_DELIMITER, ";");
+        AstIndex declaration = parser_parse_variable_declaration(context);
+        declare_variables(context, declaration);
+        ast_list_append(&parser->ast, declarations, declaration);
+        token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
 
-        while (token_match(TOKEN_KEYWORD, "var"))
+        while (token_match(context, TOKEN_KEYWORD, KW_VAR))
         {
-            parser_parse_variable_declaration();
-            token_expect(TOKEN_DELIMITER, ";");
+            declaration = parser_parse_variable_declaration(context);
+            declare_variables(context, declaration);
+            ast_list_append(&parser->ast, declarations, declaration);
+            token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
         }
     }
 }
 
 // <statement part> ::= <compound statement>
-void parser_parse_statement_part()
+AstIndex parser_parse_statement_part(CompilerContext *context)
 {
-    parser_parse_compound_statement();
+    return parser_parse_compound_statement(context);
 }
 
 // <block> ::= <variable declaration part> <subroutine declaration part> <statement part>
-void parser_parse_block()
+AstIndex parser_parse_block(CompilerContext *context, AstIndex parameters)
 {
-    parser_parse_variable_declaration_part();
-    parser_parse_subroutine_declaration_part();
-    parser_parse_statement_part();
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
+
+    scope_push(&parser->scopes);
+
+    for (AstIndex declaration = parameters; declaration != AST_NONE; declaration = ast_node(&parser->ast, declaration)->next)
+    {
+        declare_variables(context, declaration);
+    }
+
+    parser_parse_variable_declaration_part(context, &children);
+    parser_parse_subroutine_declaration_part(context, &children);
+    ast_list_append(&parser->ast, &children, parser_parse_statement_part(context));
+
+    scope_pop(&parser->scopes);
+
+    return ast_add_list(&parser->ast, AST_BLOCK, TOKEN_KIND_NONE, offset, &children);
 }
 
 //<program> ::= program <identifier> ; <block> .
-void parser_parse_program()
+AstIndex parser_parse_program(CompilerContext *context)
 {
-    token_expect(TOKEN_KEYWORD, "program");
-    token_expect(TOKEN_IDENTIFIER, NULL);
-    token_expect(TOKEN_DELIMITER, ";");
-    parser_parse_block();
-    token_expect(TOKEN_DELIMITER, ".");
+    Parser *parser = &context->parser;
+
+    uint32_t offset = parser->tokens.offsets[parser->current];
+    AstList children = {AST_NONE, AST_NONE};
+
+    token_expect(context, TOKEN_KEYWORD, KW_PROGRAM);
+    ast_list_append(&parser->ast, &children, token_expect_identifier(context));
+    token_expect(context, TOKEN_DELIMITER, DELIM_SEMI);
+    ast_list_append(&parser->ast, &children, parser_parse_block(context, AST_NONE));
+    token_expect(context, TOKEN_DELIMITER, DELIM_DOT);
+
+    return ast_add_list(&parser->ast, AST_PROGRAM, TOKEN_KIND_NONE, offset, &children);
 }
 
-void parser_init()
+void parser_init(CompilerContext *context)
 {
-    token_advance(); // Inicializa o primeiro token
+    Parser *parser = &context->parser;
+
+    // A árvore anterior deixa de valer antes que um erro léxico interrompa a compilação
+    parser->root = AST_NONE;
+
+    // A memória dos tokens, do AST e das pilhas da compilação anterior é reutilizada
+    token_stream_clear(&parser->tokens);
+    scanner_next_tokens(context, &parser->tokens, UINT32_MAX);
+    parser->current = 0;
+    parser->replay = NULL;
+    parser->statement_offset = UINT32_MAX;
+    ast_reset(&parser->ast);
+    parser->operator_count = parser->operand_count = 0;
+    parser->first_error_offset = parser->last_error_offset = parser->recovery_offset = 0;
+    parser->error_count = 0;
+    parser->max_errors = context->options.max_errors;
+    parser->tentative = false;
+    scope_stack_reset(&parser->scopes);
 }
 
-void parser_parse()
+void parser_init_replay(CompilerContext *context, const TokenDump *dump)
 {
-    parser_parse_program();
+    Parser *parser = &context->parser;
+
+    token_stream_clear(&parser->tokens);
+    token_dump_load(dump, &parser->tokens);
+    parser->current = 0;
+    parser->replay = dump;
+    ast_reset(&parser->ast);
+    parser->root = AST_NONE;
+    parser->operator_count = parser->operand_count = 0;
+    parser->first_error_offset = parser->last_error_offset = parser->recovery_offset = 0;
+    parser->error_count = 0;
+    parser->max_errors = context->options.max_errors;
+    parser->tentative = false;
+    scope_stack_reset(&parser->scopes);
 }
 
-void parser_cleanup()
+void parser_restore(CompilerContext *context, AstIndex root, int error_count, uint32_t first_error_offset, uint32_t last_error_offset, uint32_t recovery_offset)
 {
-    if (current_token)
+    Parser *parser = &context->parser;
+
+    token_stream_clear(&parser->tokens);
+    parser->current = 0;
+    parser->replay = NULL;
+    parser->root = root;
+    parser->operator_count = parser->operand_count = 0;
+    parser->error_count = error_count;
+    parser->first_error_offset = first_error_offset;
+    parser->last_error_offset = last_error_offset;
+    parser->recovery_offset = recovery_offset;
+    parser->live_nodes = parser->ast.count - 1;
+    parser->max_errors = context->options.max_errors;
+    parser->tentative = false;
+    scope_stack_reset(&parser->scopes);
+}
+
+AstIndex parser_parse(CompilerContext *context)
+{
+    context->parser.root = parser_parse_program(context);
+    context->parser.live_nodes = context->parser.ast.count - 1;
+    return context->parser.root;
+}
+
+/* Reanálise incremental */
+
+/**
+ * @return O último filho AST_BLOCK de node, ou AST_NONE se um erro de sintaxe o substituiu.
+ */
+static AstIndex node_block(const Ast *ast, AstIndex node)
+{
+    AstIndex block = AST_NONE;
+
+    for (AstIndex child = ast_node(ast, node)->first; child != AST_NONE; child = ast_node(ast, child)->next)
     {
-        free(current_token);
-        current_token = NULL;
+        if (ast_node(ast, child)->kind == AST_BLOCK)
+        {
+            block = child;
+        }
     }
+
+    return block;
+}
+
+/**
+ * @brief Declara de novo, no escopo atual, os nomes de uma declaração que já foi analisada:
+ *        as variáveis de uma AST_VAR_DECLARATION ou o nome de uma subrotina. Os erros já
+ *        foram registrados pela análise anterior, e outros nós são ignorados.
+ */
+static void restore_declaration(CompilerContext *context, AstIndex declaration)
+{
+    Parser *parser = &context->parser;
+
+    const AstNode *node = ast_node(&parser->ast, declaration);
+
+    switch (node->kind)
+    {
+    case AST_VAR_DECLARATION:
+        for (AstIndex name = node->first; name != AST_NONE; name = ast_node(&parser->ast, name)->next)
+        {
+            scope_add(context, name, AST_VAR_DECLARATION, node->op, node->flags);
+        }
+        break;
+
+    case AST_PROCEDURE:
+    case AST_FUNCTION:
+        scope_add(context, node->first, node->kind, node->op, 0);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Procura, entre os filhos de block, a declaração de subrotina que contém o trecho [start, end).
+ *        Uma declaração vai do seu primeiro token até o início do irmão seguinte, que sempre
+ *        existe: o último filho de um bloco é o comando composto.
+ * @param previous Recebe o irmão anterior à declaração, ou AST_NONE se ela for o primeiro filho.
+ * @param limit Recebe o offset do fim da declaração.
+ */
+static AstIndex find_subroutine(const Ast *ast, AstIndex block, uint32_t start, uint32_t end, AstIndex *previous, uint32_t *limit)
+{
+    AstIndex before = AST_NONE;
+
+    for (AstIndex child = ast_node(ast, block)->first; child != AST_NONE; child = ast_node(ast, child)->next)
+    {
+        const AstNode *node = ast_node(ast, child);
+
+        if ((node->kind == AST_PROCEDURE || node->kind == AST_FUNCTION) && node->next != AST_NONE)
+        {
+            uint32_t next_offset = ast_node(ast, node->next)->offset;
+
+            // O primeiro caractere não pode mudar, senão o token anterior poderia mudar também
+            if (node->offset < start && end <= next_offset)
+            {
+                *previous = before;
+                *limit = next_offset;
+                return child;
+            }
+        }
+
+        before = child;
+    }
+
+    return AST_NONE;
+}
+
+/**
+ * @brief Conta os nós da subárvore com a pilha de operandos das expressões, já
+ *        que a árvore não tem limite de profundidade. Folhas usam first para o símbolo ou o valor.
+ */
+static uint32_t subtree_size(CompilerContext *context, AstIndex index)
+{
+    Parser *parser = &context->parser;
+    uint32_t base = parser->operand_count;
+    uint32_t size = 0;
+
+    operand_push(context, index);
+
+    while (parser->operand_count > base)
+    {
+        const AstNode *node = ast_node(&parser->ast, parser->operands[--parser->operand_count]);
+        size++;
+
+        if (node->kind == AST_IDENTIFIER || node->kind == AST_NUMBER || node->kind == AST_BOOLEAN)
+        {
+            continue;
+        }
+
+        for (AstIndex child = node->first; child != AST_NONE; child = ast_node(&parser->ast, child)->next)
+        {
+            operand_push(context, child);
+        }
+    }
+
+    return size;
+}
+
+/**
+ * @return Se as duas subrotinas declaram o mesmo nome, com o mesmo tipo de declaração e de resultado.
+ */
+static bool same_declaration(const Ast *ast, AstIndex first, AstIndex second)
+{
+    const AstNode *a = ast_node(ast, first);
+    const AstNode *b = ast_node(ast, second);
+
+    return a->kind == b->kind && a->op == b->op &&
+           ast_node(ast, a->first)->kind == AST_IDENTIFIER && ast_node(ast, b->first)->kind == AST_IDENTIFIER &&
+           ast_node(ast, a->first)->symbol == ast_node(ast, b->first)->symbol;
+}
+
+bool parser_reparse(CompilerContext *context, uint32_t offset, uint32_t removed, uint32_t inserted)
+{
+    Parser *parser = &context->parser;
+    Ast *ast = &parser->ast;
+
+    if (parser->replay != NULL || parser->root == AST_NONE)
+    {
+        return false;
+    }
+
+    // Com mais nós descartados que nós na árvore, a análise completa libera a arena
+    if (ast->count - 1 - parser->live_nodes > parser->live_nodes)
+    {
+        return false;
+    }
+
+    // A subrotina mais interna que contém a edição, e onde ela está na lista de filhos do bloco.
+    // Os escopos são recriados no caminho, com o que uma análise completa teria declarado até ela.
+    AstIndex parent = AST_NONE, previous = AST_NONE, target = AST_NONE;
+    uint32_t end = 0;
+
+    scope_stack_reset(&parser->scopes);
+
+    for (AstIndex block = node_block(ast, parser->root); block != AST_NONE;)
+    {
+        AstIndex before;
+        uint32_t limit;
+        AstIndex found = find_subroutine(ast, block, offset, offset + removed, &before, &limit);
+
+        if (found == AST_NONE)
+        {
+            break;
+        }
+
+        // O nome da subrotina de fora, declarado no seu bloco pai antes do seu próprio bloco
+        if (target != AST_NONE)
+        {
+            restore_declaration(context, target);
+        }
+
+        scope_push(&parser->scopes);
+
+        for (AstIndex child = target != AST_NONE ? ast_node(ast, target)->first : AST_NONE; child != AST_NONE; child = ast_node(ast, child)->next)
+        {
+            restore_declaration(context, child);
+        }
+
+        for (AstIndex child = ast_node(ast, block)->first; child != found; child = ast_node(ast, child)->next)
+        {
+            restore_declaration(context, child);
+        }
+
+        parent = block;
+        previous = before;
+        target = found;
+        end = limit;
+        block = node_block(ast, found);
+    }
+
+    if (target == AST_NONE)
+    {
+        return false;
+    }
+
+    uint32_t start = ast_node(ast, target)->offset;
+    int32_t delta = (int32_t)(inserted - removed);
+
+    // Erros antes da subrotina mudariam o estado do parser no seu início, e erros
+    // (ou uma recuperação) depois dela podem ser consequência do trecho substituído
+    if (parser->error_count > 0 && (parser->first_error_offset < start || parser->last_error_offset >= end || parser->recovery_offset >= end))
+    {
+        return false;
+    }
+
+    if (!scanner_relex(context, start, end + delta, &parser->edit_tokens))
+    {
+        return false;
+    }
+
+    // O trecho é analisado sozinho, terminado por um TOKEN_EOF no início do irmão seguinte
+    Token boundary = create_token(TOKEN_EOF, TOKEN_KIND_NONE, end + delta, 0);
+    token_stream_push(&parser->edit_tokens, &boundary);
+
+    TokenStream tokens = parser->tokens;
+    parser->tokens = parser->edit_tokens;
+    parser->edit_tokens = tokens;
+
+    if (delta != 0)
+    {
+        for (AstIndex i = 1; i < ast->count; i++)
+        {
+            AstNode *node = ast_node(ast, i);
+
+            if (node->offset >= end)
+            {
+                node->offset += (uint32_t)delta;
+            }
+        }
+    }
+
+    // O trecho pode ter virado mais de uma declaração, mas nenhuma pode continuar depois dele
+    AstList subroutines = {AST_NONE, AST_NONE};
+
+    parser->current = 0;
+    parser->error_count = 0;
+    parser->tentative = true;
+
+    for (;;)
+    {
+        TokenKind kind = parser->tokens.kinds[parser->current];
+
+        if (kind == KW_PROCEDURE)
+        {
+            ast_list_append(ast, &subroutines, parser_parse_procedure_declaration(context));
+        }
+        else if (kind == KW_FUNCTION)
+        {
+            ast_list_append(ast, &subroutines, parser_parse_function_declaration(context));
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    parser->tentative = false;
+
+    if (parser->tokens.types[parser->current] != TOKEN_EOF)
+    {
+        return false;
+    }
+
+    // Outro nome ou tipo mudaria o que os usos fora do trecho resolvem
+    if (subroutines.first == AST_NONE || subroutines.first != subroutines.last || !same_declaration(ast, target, subroutines.first))
+    {
+        return false;
+    }
+
+    parser->live_nodes += subtree_size(context, subroutines.first) - subtree_size(context, target);
+
+    AstIndex following = ast_node(ast, target)->next;
+
+    if (subroutines.last != AST_NONE)
+    {
+        ast_node(ast, subroutines.last)->next = following;
+    }
+    else
+    {
+        subroutines.first = following;
+    }
+
+    if (previous == AST_NONE)
+    {
+        ast_node(ast, parent)->first = subroutines.first;
+    }
+    else
+    {
+        ast_node(ast, previous)->next = subroutines.first;
+    }
+
+    parser->first_error_offset = parser->last_error_offset = parser->recovery_offset = 0;
+
+    return true;
+}
+
+const Ast *parser_ast(const CompilerContext *context)
+{
+    return &context->parser.ast;
+}
+
+int parser_error_count(const CompilerContext *context)
+{
+    return context->parser.error_count;
+}
+
+void parser_cleanup(CompilerContext *context)
+{
+    Parser *parser = &context->parser;
+
+    token_stream_free(&parser->tokens);
+    token_stream_free(&parser->edit_tokens);
+    scope_stack_free(&parser->scopes);
+    parser->current = 0;
+    parser->replay = NULL;
+    ast_free(&parser->ast);
+
+    free(parser->operators);
+    free(parser->operands);
+    parser->operators = NULL;
+    parser->operands = NULL;
+    parser->operator_count = parser->operator_capacity = 0;
+    parser->operand_count = parser->operand_capacity = 0;
 }
@@ -3,409 +3,867 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "token.h"
+#include "lexer.h"
 #include "logging.h"
+#include "compiler_context.h"
 
-static FILE *source_file;
-static int current_line = 1;
+#define SOURCE_READ_CHUNK 65536
 
-Token symbol_table[MAX_SYMBOLS];
-int symbol_count = 0;
+#define STREAM_WINDOW_SIZE (256 << 10) // Janela de leitura de entradas que não podem ser mapeadas
+#define STREAM_BATCH_TOKENS 4096       // Máximo de tokens entregues por vez na leitura em fluxo
 
-static bool is_letter(const char ch)
+#define PARALLEL_MIN_SOURCE_SIZE (4 << 20) // Arquivos menores são analisados sequencialmente
+#define PARALLEL_MIN_CHUNK_SIZE (1 << 20)
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+/*
+Leitura em fluxo (stdin, pipes, terminais).
+
+O código-fonte passa por uma janela de tamanho fixo. Quando o lexer chega ao
+fim dos bytes lidos no meio de um token ou comentário, a parte já analisada é
+descartada, o item incompleto é movido para o início da janela e o restante é
+completado com uma nova leitura, então nenhum token é partido entre duas
+leituras. Comentários maiores que a janela são registrados no log assim que
+deixam de caber e o restante deles é percorrido sem ser guardado.
+*/
+
+/**
+ * Fecha o descritor do código-fonte, exceto a entrada padrão.
+ */
+static void close_source(int fd)
 {
-    return isalpha(ch) || ch == '_';
+    if (fd > STDERR_FILENO)
+    {
+        close(fd);
+    }
 }
 
-// <letra> ::= _ | a | ... | z | A | ... | Z
-bool recognize_letter(const char *buffer)
+/**
+ * Lê todo o conteúdo de um descritor não mapeável (pipe, terminal, ...)
+ * para um buffer dinâmico.
+ */
+static char *read_whole_file(CompilerContext *context, int fd, size_t *size)
 {
-    if (buffer[0] == '\0')
+    size_t capacity = SOURCE_READ_CHUNK;
+    size_t length = 0;
+    char *data = (char *)malloc(capacity);
+
+    if (data == NULL)
     {
-        return false; // Empty string
+        perror("Error allocating source buffer");
+        exit(EXIT_FAILURE);
     }
 
-    for (int i = 0; buffer[i] != '\0'; i++)
+    while (1)
     {
-        if (!is_letter(buffer[i]))
+        if (length == capacity)
         {
-            return false;
+            capacity *= 2;
+            data = (char *)realloc(data, capacity);
+
+            if (data == NULL)
+            {
+                perror("Error allocating source buffer");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        ssize_t bytes_read = read(fd, data + length, capacity - length);
+
+        if (bytes_read < 0)
+        {
+            perror("Error reading source file");
+            free(data);
+            close_source(fd);
+            compiler_fail(context);
         }
+
+        if (bytes_read == 0)
+        {
+            break;
+        }
+
+        length += bytes_read;
     }
 
-    return true;
+    *size = length;
+    return data;
 }
 
-// <digito> ::= 0 | 1 | ... | 9
-bool recognize_digit(const char *buffer)
+/**
+ * Prepara a leitura em fluxo de um descritor que não pode ser mapeado.
+ */
+static void stream_init(CompilerContext *context, int fd)
 {
-    if (buffer[0] == '\0')
-    {
-        return false; // Empty string
-    }
+    Scanner *scanner = &context->scanner;
 
-    if (buffer[1] != '\0')
+    scanner->source_buffer = (char *)malloc(STREAM_WINDOW_SIZE);
+
+    if (scanner->source_buffer == NULL)
     {
-        return false; // More than one character
+        perror("Error allocating source buffer");
+        exit(EXIT_FAILURE);
     }
 
-    return isdigit(buffer[0]);
+    scanner->source_size = 0;
+    scanner->stream_fd = fd;
+    scanner->stream_base = 0;
+    scanner->stream_eof = false;
+    scanner->stream_kept_lines = UINT32_MAX;
+    scanner->stream_comment_pending = false;
+
+    // Janela vazia: a primeira chamada ao lexer pede a primeira leitura
+    lexer_init(&scanner->lexer, scanner->source_buffer, 0, scanner->source_buffer, scanner->source_buffer);
+    lexer_set_window(&scanner->lexer, scanner->source_buffer, 0, 0, scanner->source_buffer, false);
+    line_index_init_stream(&scanner->line_index, STREAM_WINDOW_SIZE);
 }
 
-// <numero> ::= <digito> {<digito>}
-bool recognize_number(const char *buffer)
+/**
+ * Prepara a análise do código-fonte inteiro, já em source_buffer.
+ */
+static void scanner_start(CompilerContext *context)
 {
-    if (buffer[0] == '\0')
+    Scanner *scanner = &context->scanner;
+
+    lexer_init(&scanner->lexer, scanner->source_buffer, scanner->source_size, scanner->source_buffer, scanner->source_buffer + scanner->source_size);
+    line_index_init(&scanner->line_index, scanner->source_buffer, scanner->source_size);
+    log_set_source(context, scanner->source_buffer, 0, &scanner->line_index);
+}
+
+void scanner_init(CompilerContext *context, const char source_filename[])
+{
+    Scanner *scanner = &context->scanner;
+
+    bool standard_input = strcmp(source_filename, "-") == 0;
+    int fd = standard_input ? STDIN_FILENO : open(source_filename, O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("Error opening source file");
+        compiler_fail(context);
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) < 0)
     {
-        return false; // Empty string
+        perror("Error opening source file");
+        close_source(fd);
+        compiler_fail(context);
     }
 
-    for (int i = 0; buffer[i] != '\0'; i++)
+    scanner->source_mapped = false;
+    scanner->source_buffer = NULL;
+    scanner->source_size = 0;
+    scanner->stream_fd = -1;
+    scanner->stream_base = 0;
+
+    // Pipes e terminais são lidos em fluxo, com memória constante
+    if (!S_ISREG(info.st_mode))
     {
-        if (!isdigit(buffer[i]))
+        stream_init(context, fd);
+        log_set_source(context, scanner->source_buffer, 0, &scanner->line_index);
+        return;
+    }
+
+    // Os tokens guardam offsets de 32 bits
+    if (info.st_size > UINT32_MAX)
+    {
+        fprintf(stderr, "Source file too large: %s\n", source_filename);
+        close_source(fd);
+        compiler_fail(context);
+    }
+
+    if (info.st_size > 0)
+    {
+        void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping != MAP_FAILED)
         {
-            return false;
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+            scanner->source_buffer = (char *)mapping;
+            scanner->source_size = info.st_size;
+            scanner->source_mapped = true;
+        }
+        else
+        {
+            // Arquivos que não puderam ser mapeados
+            scanner->source_buffer = read_whole_file(context, fd, &scanner->source_size);
+
+            if (scanner->source_size > UINT32_MAX)
+            {
+                fprintf(stderr, "Source file too large: %s\n", source_filename);
+                close_source(fd);
+                compiler_fail(context);
+            }
         }
     }
 
-    return true;
+    close_source(fd);
+    scanner_start(context);
 }
 
-// <boolean> ::= true | false
-bool recognize_boolean(const char *buffer)
+void scanner_init_buffer(CompilerContext *context, char *source, size_t size)
 {
-    return strcmp(buffer, "true") == 0 || strcmp(buffer, "false") == 0;
+    Scanner *scanner = &context->scanner;
+
+    scanner->source_buffer = source;
+    scanner->source_size = size;
+    scanner->source_mapped = false;
+    scanner->stream_fd = -1;
+    scanner->stream_base = 0;
+
+    // Os tokens guardam offsets de 32 bits
+    if (size > UINT32_MAX)
+    {
+        fprintf(stderr, "Source file too large\n");
+        compiler_fail(context);
+    }
+
+    scanner_start(context);
 }
 
-// <keyword> ::= program | begin | ...
-bool recognize_keyword(const char *buffer)
+/**
+ * Registra um erro léxico e interrompe a compilação.
+ */
+static void lexical_error(CompilerContext *context, LexResult result, const Token *token)
 {
-    for (int i = 0; i < num_keywords; i++)
+    Scanner *scanner = &context->scanner;
+
+    if (result == LEX_UNTERMINATED_COMMENT)
     {
-        if (strcmp(buffer, keywords[i]) == 0)
+        // O início de um comentário longo pode já ter saído do índice de linhas
+        int line = scanner->stream_comment_line;
+
+        if (!scanner->stream_comment_pending)
         {
-            return true;
+            line_index_locate(&scanner->line_index, token->offset, &line, NULL);
         }
+
+        // Os tokens já registrados são escritos antes da mensagem
+        log_cleanup(context);
+        fprintf(context->options.output, "Lexical Error: Unterminated comment starting at line %d\n", line);
+    }
+    else
+    {
+        log_lexical_error(context, token->offset);
     }
-    return false;
+
+    compiler_fail(context);
 }
 
-// <identificador> ::= <letra> {<letra> | <dígito>}
-bool recognize_identifier(const char *buffer)
+/**
+ * Finaliza um token na ordem do código-fonte: interna identificadores e registra o token no log.
+ * @return false se o token for um comentário, que não é entregue ao analisador sintático.
+ */
+static bool accept_token(CompilerContext *context, Token *token)
 {
-    if (buffer[0] == '\0')
-    {
-        return false; // Empty string
-    }
+    Scanner *scanner = &context->scanner;
 
-    if (!is_letter(buffer[0]))
+    if (token->type == TOKEN_IDENTIFIER)
     {
-        return false;
+        token->symbol = symbol_table_intern(&context->symbol_table, scanner->source_buffer + (token->offset - scanner->stream_base), token->length);
     }
 
-    for (int i = 1; buffer[i] != '\0'; i++)
+    log_token(context, token);
+
+    return token->type != TOKEN_COMMENT;
+}
+
+/**
+ * Descarta da janela de leitura o que já foi analisado, preservando o item
+ * incompleto no cursor do lexer, e a completa com os próximos bytes.
+ */
+static void stream_refill(CompilerContext *context)
+{
+    Scanner *scanner = &context->scanner;
+
+    const char *keep = scanner->lexer.cursor;
+    size_t kept = scanner->source_buffer + scanner->source_size - keep;
+
+    if (kept == STREAM_WINDOW_SIZE)
     {
-        if (!(is_letter(buffer[i]) || isdigit(buffer[i])))
+        if (keep[0] != '/' || keep[1] != '*')
         {
-            return false;
+            int line;
+            line_index_locate(&scanner->line_index, scanner->stream_base, &line, NULL);
+            log_cleanup(context);
+            fprintf(context->options.output, "Lexical Error at line %d: token longer than %d characters\n", line, STREAM_WINDOW_SIZE);
+            compiler_fail(context);
         }
+
+        // O comentário não cabe na janela: o início é guardado, e ele só é registrado
+        // quando terminar, como na leitura do arquivo inteiro
+        memcpy(scanner->stream_comment_text, keep, MAX_COMMENT_LENGTH - 1);
+        line_index_locate(&scanner->line_index, scanner->stream_base, &scanner->stream_comment_line, &scanner->stream_comment_column);
+        scanner->stream_comment_pending = true;
+
+        lexer_skip_comment(&scanner->lexer);
+        keep = scanner->lexer.cursor;
+        kept = scanner->source_buffer + scanner->source_size - keep;
     }
 
-    return true;
-}
+    memmove(scanner->source_buffer, keep, kept);
+    scanner->stream_base += keep - scanner->source_buffer;
+    scanner->source_size = kept;
 
-// <operador aritmético> ::= + | - | * | div
-bool recognize_arithmetic_operator(const char *buffer)
-{
-    for (int i = 0; i < num_arithmetic_operators; i++)
+    while (scanner->source_size < STREAM_WINDOW_SIZE && !scanner->stream_eof)
     {
-        if (strcmp(buffer, arithmetic_operators[i]) == 0)
+        ssize_t bytes_read = read(scanner->stream_fd, scanner->source_buffer + scanner->source_size, STREAM_WINDOW_SIZE - scanner->source_size);
+
+        if (bytes_read < 0)
         {
-            return true;
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            perror("Error reading source file");
+            compiler_fail(context);
         }
+
+        if (bytes_read == 0)
+        {
+            scanner->stream_eof = true;
+        }
+
+        scanner->source_size += bytes_read;
+    }
+
+    // Os tokens guardam offsets de 32 bits
+    if ((uint64_t)scanner->stream_base + scanner->source_size > UINT32_MAX)
+    {
+        fprintf(stderr, "Source file too large\n");
+        compiler_fail(context);
     }
-    return false;
+
+    line_index_discard(&scanner->line_index, scanner->stream_base < scanner->stream_kept_lines ? scanner->stream_base : scanner->stream_kept_lines);
+    line_index_append(&scanner->line_index, scanner->source_buffer + kept, scanner->source_size - kept, scanner->stream_base + kept);
+
+    lexer_set_window(&scanner->lexer, scanner->source_buffer, scanner->source_size, scanner->stream_base, scanner->source_buffer, scanner->stream_eof);
+    log_set_source(context, scanner->source_buffer, scanner->stream_base, &scanner->line_index);
 }
 
-// <operador relacional> ::= = | <> | < | <= | > | >=
-bool recognize_relational_operator(const char *buffer)
+/**
+ * Lê o próximo token entregue ao analisador sintático.
+ * @param refill Se falso, nada é descartado da janela de leitura: retorna false
+ *               quando for preciso completá-la para continuar.
+ */
+static bool next_token(CompilerContext *context, Token *token, bool refill)
 {
-    for (int i = 0; i < num_relational_operators; i++)
+    Scanner *scanner = &context->scanner;
+
+    while (1)
     {
-        if (strcmp(buffer, relational_operators[i]) == 0)
+        LexResult result = lexer_next(&scanner->lexer, token);
+
+        if (result == LEX_NEED_MORE)
+        {
+            if (!refill)
+            {
+                return false;
+            }
+
+            stream_refill(context);
+            continue;
+        }
+
+        if (result == LEX_END)
         {
+            *token = create_token(TOKEN_EOF, TOKEN_KIND_NONE, scanner->stream_base + scanner->source_size, 0);
+            log_end_of_input(context, token->offset);
             return true;
         }
-    }
-    return false;
-}
 
-// <operador lógico> ::= and | or | not
-bool recognize_logical_operator(const char *buffer)
-{
-    for (int i = 0; i < num_logical_operators; i++)
-    {
-        if (strcmp(buffer, logical_operators[i]) == 0)
+        if (result != LEX_TOKEN && result != LEX_COMMENT)
+        {
+            lexical_error(context, result, token);
+        }
+
+        // Comentário longo que deixou de caber na janela, registrado com o início guardado
+        if (result == LEX_COMMENT && scanner->stream_comment_pending)
+        {
+            // O comentário é registrado na linha em que termina, que está na janela
+            int line;
+            line_index_locate(&scanner->line_index, token->offset + token->length - 1, &line, NULL);
+
+            scanner->stream_comment_pending = false;
+            log_token_at(context, token, scanner->stream_comment_text, line, scanner->stream_comment_column);
+            continue;
+        }
+
+        if (accept_token(context, token))
         {
             return true;
         }
     }
-    return false;
 }
 
-// <operador de atribuição> ::= :=
-bool recognize_assignment_operator(const char *buffer)
+Token get_token(CompilerContext *context)
 {
-    return strcmp(buffer, ":=") == 0;
+    Token token;
+    next_token(context, &token, true);
+    return token;
 }
 
-// <delimitador> ::= ( | ) | , | : | . | ;
-bool recognize_delimiter(const char *buffer)
+/*
+Análise léxica paralela.
+
+O código-fonte é dividido em trechos que começam em um espaço em branco, de
+forma que nenhum token atravesse a divisão. Cada trecho é analisado por uma
+thread como se começasse fora de um comentário, sem internar identificadores
+nem registrar nada no log.
+
+A junção é sequencial. Um trecho só é aproveitado a partir da posição em que o
+trecho anterior realmente terminou: se ele começou dentro de um comentário (ou
+de um token) do anterior, o código é reanalisado a partir dessa posição até
+encontrar um token ou comentário que o trecho também reconheceu ali, ponto a
+partir do qual os dois resultados são idênticos. O resultado é o mesmo fluxo
+de tokens, na mesma ordem, produzido por get_token.
+*/
+
+typedef struct
+{
+    const char *start; // Início nominal do trecho
+    const char *limit; // Início do próximo trecho
+    TokenStream items; // Tokens e comentários reconhecidos no trecho
+    const char *stop;  // Onde o lexer do trecho parou (ou a posição antes do erro)
+    LexResult result;  // LEX_END ou o erro que interrompeu o trecho
+} Chunk;
+
+typedef struct
+{
+    const char *source;
+    size_t source_size;
+    Chunk *chunks;
+    int chunk_count;
+    int next_chunk; // Próximo trecho a ser analisado, incrementado atomicamente
+} ChunkQueue;
+
+static void lex_chunk(const ChunkQueue *queue, Chunk *chunk)
 {
-    for (int i = 0; i < num_delimiters; i++)
+    Lexer chunk_lexer;
+    Token token;
+
+    lexer_init(&chunk_lexer, queue->source, queue->source_size, chunk->start, chunk->limit);
+    token_stream_init(&chunk->items);
+
+    while (1)
     {
-        if (strcmp(buffer, delimiters[i]) == 0)
+        const char *before = chunk_lexer.cursor;
+
+        chunk->result = lexer_next(&chunk_lexer, &token);
+
+        if (chunk->result == LEX_TOKEN || chunk->result == LEX_COMMENT)
         {
-            return true;
+            token_stream_push(&chunk->items, &token);
+            continue;
         }
+
+        // Em caso de erro, que pode ser só especulativo, a junção reanalisa a partir daqui
+        chunk->stop = chunk->result == LEX_END ? chunk_lexer.cursor : before;
+
+        return;
     }
-    return false;
 }
 
-// <comentario> ::= /* { qualquer caractere } */
-bool recognize_comment(const char *buffer)
+static void *chunk_worker(void *argument)
 {
-    int len = strlen(buffer);
+    ChunkQueue *queue = (ChunkQueue *)argument;
+    int index;
 
-    if (len < 4)
+    while ((index = __atomic_fetch_add(&queue->next_chunk, 1, __ATOMIC_RELAXED)) < queue->chunk_count)
     {
-        return false; // Minimum length for a comment is 4: "/* */"
+        lex_chunk(queue, &queue->chunks[index]);
     }
 
-    return buffer[0] == '/' && buffer[1] == '*' && buffer[len - 2] == '*' && buffer[len - 1] == '/';
+    return NULL;
 }
 
-void scanner_init(const char source_filename[])
+/**
+ * @return O índice do primeiro item do trecho que começa em offset, ou items.count se não houver.
+ */
+static uint32_t find_chunk_item(const TokenStream *items, uint32_t offset)
 {
-    source_file = fopen(source_filename, "r");
+    uint32_t low = 0;
+    uint32_t high = items->count;
 
-    if (source_file == NULL)
+    while (low < high)
     {
-        perror("Error opening source file");
-        exit(EXIT_FAILURE);
+        uint32_t middle = low + (high - low) / 2;
+
+        if (items->offsets[middle] < offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
     }
 
-    current_line = 1;
+    return low < items->count && items->offsets[low] == offset ? low : items->count;
 }
 
-Token *get_token()
+/**
+ * Junta os trechos no fluxo, na ordem do código-fonte.
+ * @param error Recebe a posição do erro léxico, se houver.
+ * @return LEX_END, ou o erro léxico que interrompeu a análise.
+ */
+static LexResult merge_chunks(CompilerContext *context, Chunk *chunks, int chunk_count, TokenStream *stream, Token *error)
 {
-    char buffer[MAX_TOKEN_LENGTH];
-    int buffer_index = 0;
-    int ch;
+    Scanner *scanner = &context->scanner;
 
-    // 1. Pular espaços em branco
-    while ((ch = fgetc(source_file)) != EOF && isspace(ch))
+    const char *position = scanner->source_buffer; // Onde o lexer sequencial estaria
+    Token token;
+
+    for (int i = 0; i < chunk_count; i++)
     {
-        if (ch == '\n')
+        Chunk *chunk = &chunks[i];
+
+        // Trecho inteiramente dentro de um comentário do trecho anterior
+        if (position >= chunk->limit)
         {
-            current_line++;
+            continue;
         }
-    }
 
-    if (ch == EOF)
-    {
-        return NULL;
-    }
+        uint32_t first = position == chunk->start ? 0 : find_chunk_item(&chunk->items, position - scanner->source_buffer);
 
-    // Reconhecer comentários
-    if (ch == '/')
-    {
-        int next_ch = fgetc(source_file);
-        if (next_ch == '*')
+        if (first == chunk->items.count && position != chunk->start)
         {
-            // Processar comentário completo
-            char comment_buffer[MAX_COMMENT_LENGTH];
-            int comment_index = 0;
-
-            comment_buffer[comment_index++] = ch;
-            comment_buffer[comment_index++] = next_ch;
+            // Reanalisa até sincronizar com o resultado especulativo do trecho
+            Lexer fixup;
+            lexer_init(&fixup, scanner->source_buffer, scanner->source_size, position, chunk->limit);
 
-            bool comment_closed = false;
-            while ((ch = fgetc(source_file)) != EOF)
+            while (1)
             {
-                if (ch == '\n')
+                LexResult result = lexer_next(&fixup, &token);
+
+                if (result == LEX_END)
                 {
-                    current_line++;
+                    break;
                 }
 
-                if (comment_index < MAX_COMMENT_LENGTH - 1)
+                if (result != LEX_TOKEN && result != LEX_COMMENT)
                 {
-                    comment_buffer[comment_index++] = ch;
+                    *error = token;
+                    return result;
                 }
 
-                if (ch == '*')
+                first = find_chunk_item(&chunk->items, token.offset);
+
+                if (first < chunk->items.count)
                 {
-                    int potential_end = fgetc(source_file);
-                    if (potential_end == '/')
-                    {
-                        if (comment_index < MAX_COMMENT_LENGTH - 1)
-                        {
-                            comment_buffer[comment_index++] = potential_end;
-                        }
-                        comment_closed = true;
-                        break;
-                    }
-                    else
-                    {
-                        ungetc(potential_end, source_file);
-                    }
+                    break;
+                }
+
+                if (accept_token(context, &token))
+                {
+                    token_stream_push(stream, &token);
                 }
             }
 
-            if (!comment_closed)
+            // O trecho inteiro foi reanalisado
+            if (first == chunk->items.count)
             {
-                fprintf(stderr, "Lexical Error: Unterminated comment starting at line %d\n", current_line);
-                exit(EXIT_FAILURE);
+                position = fixup.cursor;
+                continue;
             }
+        }
 
-            comment_buffer[comment_index] = '\0';
-
-            Token *token = create_token(TOKEN_COMMENT, comment_buffer, comment_buffer + comment_index, current_line);
-            log_token(token);
+        for (uint32_t j = first; j < chunk->items.count; j++)
+        {
+            token = token_stream_get(&chunk->items, j);
 
-            free(token->value);
-            free(token);
-            
-            return get_token(); // Pegar o próximo token após o comentário
+            if (accept_token(context, &token))
+            {
+                token_stream_push(stream, &token);
+            }
         }
-        else
+
+        position = chunk->stop;
+
+        if (chunk->result != LEX_END)
         {
-            ungetc(next_ch, source_file);
+            // Erro léxico confirmado: a análise sequencial a partir daqui o reproduz
+            Lexer failed;
+            lexer_init(&failed, scanner->source_buffer, scanner->source_size, position, scanner->source_buffer + scanner->source_size);
+
+            LexResult result;
+            while ((result = lexer_next(&failed, &token)) == LEX_TOKEN || result == LEX_COMMENT)
+            {
+                if (accept_token(context, &token))
+                {
+                    token_stream_push(stream, &token);
+                }
+            }
+
+            *error = token;
+            return result;
         }
     }
 
-    // Colocar o primeiro caractere válido de volta
-    ungetc(ch, source_file);
+    token = create_token(TOKEN_EOF, TOKEN_KIND_NONE, scanner->source_size, 0);
+    token_stream_push(stream, &token);
+    log_end_of_input(context, token.offset);
 
-    // 2. Encontrar a maior correspondência
-    int last_match_length = 0;
-    TokenType last_match_type = TOKEN_IDENTIFIER;
+    return LEX_END;
+}
 
-    while (1)
-    {
-        ch = fgetc(source_file);
+static bool is_split_point(char ch)
+{
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
 
-        if (ch == EOF)
-            break;
+static void tokenize_parallel(CompilerContext *context, TokenStream *stream, int chunk_count, int thread_count)
+{
+    Scanner *scanner = &context->scanner;
 
-        buffer[buffer_index++] = ch;
-        buffer[buffer_index] = '\0';
+    Chunk *chunks = (Chunk *)calloc(chunk_count, sizeof(Chunk));
+    pthread_t *threads = (pthread_t *)malloc(thread_count * sizeof(pthread_t));
 
-        // Verifica quais reconhecedores ainda correspondem ao buffer atual
-        int current_match = 0;
+    if (chunks == NULL || threads == NULL)
+    {
+        perror("Error allocating scanner chunks");
+        exit(EXIT_FAILURE);
+    }
 
-        if (recognize_number(buffer))
-        {
-            last_match_type = TOKEN_NUMBER;
-            current_match = 1;
-        }
+    const char *source_end = scanner->source_buffer + scanner->source_size;
+    const char *start = scanner->source_buffer;
 
-        if (recognize_identifier(buffer))
-        {
-            last_match_type = TOKEN_IDENTIFIER;
-            current_match = 1;
-        }
+    for (int i = 0; i < chunk_count; i++)
+    {
+        const char *limit = i == chunk_count - 1 ? source_end : scanner->source_buffer + (scanner->source_size / chunk_count) * (i + 1);
 
-        if (recognize_keyword(buffer))
+        if (limit < start)
         {
-            last_match_type = TOKEN_KEYWORD;
-            current_match = 1;
+            limit = start;
         }
 
-        if (recognize_boolean(buffer))
+        while (limit < source_end && !is_split_point(*limit))
         {
-            last_match_type = TOKEN_BOOLEAN;
-            current_match = 1;
+            limit++;
         }
 
-        if (recognize_arithmetic_operator(buffer))
-        {
-            last_match_type = TOKEN_OPERATOR_ARITHMETIC;
-            current_match = 1;
-        }
+        chunks[i].start = start;
+        chunks[i].limit = limit;
+        start = limit;
+    }
 
-        if (recognize_relational_operator(buffer))
-        {
-            last_match_type = TOKEN_OPERATOR_RELATIONAL;
-            current_match = 1;
-        }
+    ChunkQueue queue = {scanner->source_buffer, scanner->source_size, chunks, chunk_count, 0};
+    int started = 0;
 
-        if (recognize_logical_operator(buffer))
+    // A thread atual também processa trechos
+    for (int i = 1; i < thread_count; i++)
+    {
+        if (pthread_create(&threads[started], NULL, chunk_worker, &queue) == 0)
         {
-            last_match_type = TOKEN_OPERATOR_LOGICAL;
-            current_match = 1;
+            started++;
         }
+    }
 
-        if (recognize_assignment_operator(buffer))
-        {
-            last_match_type = TOKEN_OPERATOR_ASSIGNMENT;
-            current_match = 1;
-        }
+    chunk_worker(&queue);
 
-        if (recognize_delimiter(buffer))
-        {
-            last_match_type = TOKEN_DELIMITER;
-            current_match = 1;
-        }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    Token error = {0};
+    LexResult result = merge_chunks(context, chunks, chunk_count, stream, &error);
+
+    for (int i = 0; i < chunk_count; i++)
+    {
+        token_stream_free(&chunks[i].items);
+    }
+
+    free(chunks);
+    free(threads);
+
+    if (result != LEX_END)
+    {
+        lexical_error(context, result, &error);
+    }
+}
+
+void scanner_set_threads(CompilerContext *context, int threads)
+{
+    Scanner *scanner = &context->scanner;
 
-        if (current_match)
+    scanner->threads = threads > 0 ? threads : 1;
+}
+
+void scanner_tokenize_all(CompilerContext *context, TokenStream *stream)
+{
+    Scanner *scanner = &context->scanner;
+
+    int chunk_count = scanner->threads * PARALLEL_CHUNKS_PER_THREAD;
+
+    if (scanner->source_size / PARALLEL_MIN_CHUNK_SIZE < (size_t)chunk_count)
+    {
+        chunk_count = scanner->source_size / PARALLEL_MIN_CHUNK_SIZE;
+    }
+
+    if (scanner->threads > 1 && scanner->source_size >= PARALLEL_MIN_SOURCE_SIZE && chunk_count > 1)
+    {
+        tokenize_parallel(context, stream, chunk_count, scanner->threads);
+        scanner->lexer.cursor = scanner->lexer.end;
+        return;
+    }
+
+    Token token;
+
+    do
+    {
+        token = get_token(context);
+        token_stream_push(stream, &token);
+    } while (token.type != TOKEN_EOF);
+}
+
+void scanner_next_tokens(CompilerContext *context, TokenStream *stream, uint32_t kept_lines)
+{
+    Scanner *scanner = &context->scanner;
+
+    stream->count = 0;
+    scanner->stream_kept_lines = kept_lines;
+
+    if (scanner->stream_fd < 0)
+    {
+        scanner_tokenize_all(context, stream);
+        return;
+    }
+
+    // Só o primeiro token pode descartar parte da janela (e o texto do lote anterior)
+    Token token = get_token(context);
+    token_stream_push(stream, &token);
+
+    while (token.type != TOKEN_EOF && stream->count < STREAM_BATCH_TOKENS && next_token(context, &token, false))
+    {
+        token_stream_push(stream, &token);
+    }
+}
+
+void scanner_edit(CompilerContext *context, uint32_t offset, uint32_t removed, const char *text, uint32_t inserted)
+{
+    Scanner *scanner = &context->scanner;
+
+    size_t tail = scanner->source_size - offset - removed;
+    size_t size = scanner->source_size - removed + inserted;
+    char *source = scanner->source_buffer;
+
+    if (scanner->source_mapped)
+    {
+        // O mapeamento é só de leitura: o código-fonte é copiado na primeira edição
+        source = (char *)malloc(size + 1);
+
+        if (source == NULL)
         {
-            last_match_length = buffer_index;
+            perror("Error allocating source buffer");
+            exit(EXIT_FAILURE);
         }
-        else
+
+        memcpy(source, scanner->source_buffer, offset);
+        memcpy(source + offset + inserted, scanner->source_buffer + offset + removed, tail);
+        munmap(scanner->source_buffer, scanner->source_size);
+        scanner->source_mapped = false;
+    }
+    else
+    {
+        if (inserted > removed)
         {
-            // O caractere quebrou todas as correspondências do buffer
-            ungetc(ch, source_file); // Voltar uma posição no arquivo
-            break;
+            source = (char *)realloc(source, size + 1);
+
+            if (source == NULL)
+            {
+                perror("Error allocating source buffer");
+                exit(EXIT_FAILURE);
+            }
         }
+
+        memmove(source + offset + inserted, source + offset + removed, tail);
     }
 
-    // 3. Criar o token com base na maior correspondência encontrada
-    if (last_match_length > 0)
+    memcpy(source + offset, text, inserted);
+
+    scanner->source_buffer = source;
+    scanner->source_size = size;
+
+    // As linhas são recalculadas sob demanda, só se algum diagnóstico precisar delas
+    line_index_free(&scanner->line_index);
+    scanner_start(context);
+    scanner->lexer.cursor = scanner->lexer.end;
+}
+
+bool scanner_relex(CompilerContext *context, uint32_t start, uint32_t end, TokenStream *stream)
+{
+    Scanner *scanner = &context->scanner;
+
+    Lexer lexer;
+    Token token;
+    LexResult result;
+
+    token_stream_clear(stream);
+    lexer_init(&lexer, scanner->source_buffer, scanner->source_size, scanner->source_buffer + start, scanner->source_buffer + end);
+
+    while ((result = lexer_next(&lexer, &token)) == LEX_TOKEN || result == LEX_COMMENT)
     {
-        buffer[last_match_length] = '\0';
-        Token *token = create_token(last_match_type, buffer, buffer + last_match_length, current_line);
-        log_token(token);
+        if (result == LEX_COMMENT)
+        {
+            continue;
+        }
 
-        if (token->type == TOKEN_IDENTIFIER)
+        if (token.type == TOKEN_IDENTIFIER)
         {
-            symbol_table[symbol_count++] = *token;
+            token.symbol = symbol_table_intern(&context->symbol_table, scanner->source_buffer + token.offset, token.length);
         }
 
-        return token;
+        token_stream_push(stream, &token);
     }
 
-    // Se o caractere atual for EOF (acabou o arquivo)
-    if (ch == EOF)
-    {
-        return NULL;
-    }
+    // Um token ou comentário que passa de end mudaria os tokens seguintes
+    return result == LEX_END && lexer.cursor == scanner->source_buffer + end;
+}
+
+const char *scanner_text(CompilerContext *context, uint32_t offset)
+{
+    Scanner *scanner = &context->scanner;
 
-    // Nenhum token foi reconhecido
-    ch = fgetc(source_file);
-    log_lexical_error(current_line, ch);
-    exit(EXIT_FAILURE);
+    return scanner->source_buffer + (offset - scanner->stream_base);
 }
 
-void scanner_cleanup()
+void scanner_cleanup(CompilerContext *context)
 {
-    if (source_file)
+    Scanner *scanner = &context->scanner;
+
+    if (scanner->source_mapped)
     {
-        fclose(source_file);
-        source_file = NULL;
+        munmap(scanner->source_buffer, scanner->source_size);
     }
-}
\ No newline at end of file
+    else
+    {
+        free(scanner->source_buffer);
+    }
+
+    if (scanner->stream_fd > STDERR_FILENO)
+    {
+        close(scanner->stream_fd);
+    }
+
+    scanner->source_buffer = NULL;
+    scanner->source_size = 0;
+    scanner->source_mapped = false;
+    scanner->stream_fd = -1;
+    scanner->stream_base = 0;
+
+    line_index_free(&scanner->line_index);
+}
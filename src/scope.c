@@ -0,0 +1,159 @@
+#include "scope.h"
+
+#include <string.h>
+
+/**
+ * Cabeçalho de um escopo na arena. A tabela vem logo depois, exceto quando
+ * foi realocada para crescer: a anterior fica sem uso até o escopo ser fechado.
+ */
+typedef struct
+{
+    uint32_t parent;     // Offset do escopo de fora, ou SCOPE_NONE
+    uint32_t slots;      // Offset da tabela de ScopeEntry
+    uint32_t slot_count; // Sempre uma potência de 2
+    uint32_t count;
+} Scope;
+
+// Nenhuma declaração usa o nó 0 (AST_NONE), então posições zeradas pela arena estão vazias
+#define SLOT_EMPTY 0
+
+static inline Scope *scope_at(const ScopeStack *scopes, uint32_t offset)
+{
+    return (Scope *)arena_at(&scopes->arena, offset);
+}
+
+static inline ScopeEntry *scope_slots(const ScopeStack *scopes, const Scope *scope)
+{
+    return (ScopeEntry *)arena_at(&scopes->arena, scope->slots);
+}
+
+/**
+ * Os IDs são sequenciais: a multiplicação (hash de Fibonacci) espalha IDs vizinhos pela tabela.
+ */
+static inline uint32_t scope_hash(uint32_t symbol)
+{
+    return symbol * 0x9E3779B1u;
+}
+
+/**
+ * @return A posição de symbol na tabela, ou a posição vazia onde ele seria inserido.
+ */
+static ScopeEntry *scope_probe(ScopeEntry *slots, uint32_t slot_count, uint32_t symbol)
+{
+    uint32_t mask = slot_count - 1;
+
+    for (uint32_t index = scope_hash(symbol) & mask;; index = (index + 1) & mask)
+    {
+        if (slots[index].declaration == SLOT_EMPTY || slots[index].symbol == symbol)
+        {
+            return &slots[index];
+        }
+    }
+}
+
+static void scope_grow(ScopeStack *scopes)
+{
+    uint32_t slot_count = scope_at(scopes, scopes->top)->slot_count * 2;
+    uint32_t slots = arena_alloc(&scopes->arena, slot_count * sizeof(ScopeEntry));
+
+    Scope *scope = scope_at(scopes, scopes->top);
+    ScopeEntry *old_slots = scope_slots(scopes, scope);
+    ScopeEntry *new_slots = (ScopeEntry *)arena_at(&scopes->arena, slots);
+
+    for (uint32_t i = 0; i < scope->slot_count; i++)
+    {
+        if (old_slots[i].declaration != SLOT_EMPTY)
+        {
+            *scope_probe(new_slots, slot_count, old_slots[i].symbol) = old_slots[i];
+        }
+    }
+
+    scope->slots = slots;
+    scope->slot_count = slot_count;
+}
+
+void scope_stack_init(ScopeStack *scopes)
+{
+    arena_init(&scopes->arena);
+    scopes->top = SCOPE_NONE;
+    scopes->depth = 0;
+}
+
+void scope_stack_reset(ScopeStack *scopes)
+{
+    arena_reset(&scopes->arena);
+    scopes->top = SCOPE_NONE;
+    scopes->depth = 0;
+}
+
+void scope_push(ScopeStack *scopes)
+{
+    uint32_t offset = arena_alloc(&scopes->arena, sizeof(Scope));
+    uint32_t slots = arena_alloc(&scopes->arena, SCOPE_INITIAL_SLOTS * sizeof(ScopeEntry));
+
+    Scope *scope = scope_at(scopes, offset);
+    scope->parent = scopes->top;
+    scope->slots = slots;
+    scope->slot_count = SCOPE_INITIAL_SLOTS;
+    scope->count = 0;
+
+    scopes->top = offset;
+    scopes->depth++;
+}
+
+void scope_pop(ScopeStack *scopes)
+{
+    uint32_t offset = scopes->top;
+
+    scopes->top = scope_at(scopes, offset)->parent;
+    scopes->depth--;
+    arena_rewind(&scopes->arena, offset);
+}
+
+const ScopeEntry *scope_declare(ScopeStack *scopes, const ScopeEntry *entry)
+{
+    Scope *scope = scope_at(scopes, scopes->top);
+
+    if ((scope->count + 1) * 4 > scope->slot_count * 3)
+    {
+        scope_grow(scopes);
+        scope = scope_at(scopes, scopes->top);
+    }
+
+    ScopeEntry *slot = scope_probe(scope_slots(scopes, scope), scope->slot_count, entry->symbol);
+
+    if (slot->declaration != SLOT_EMPTY)
+    {
+        return slot;
+    }
+
+    *slot = *entry;
+    scope->count++;
+
+    return NULL;
+}
+
+const ScopeEntry *scope_lookup(const ScopeStack *scopes, uint32_t symbol)
+{
+    for (uint32_t offset = scopes->top; offset != SCOPE_NONE;)
+    {
+        const Scope *scope = scope_at(scopes, offset);
+        const ScopeEntry *slot = scope_probe(scope_slots(scopes, scope), scope->slot_count, symbol);
+
+        if (slot->declaration != SLOT_EMPTY)
+        {
+            return slot;
+        }
+
+        offset = scope->parent;
+    }
+
+    return NULL;
+}
+
+void scope_stack_free(ScopeStack *scopes)
+{
+    arena_free(&scopes->arena);
+    scopes->top = SCOPE_NONE;
+    scopes->depth = 0;
+}
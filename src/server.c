@@ -0,0 +1,580 @@
+#include "server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "allocation.h"
+
+#define SERVER_BACKLOG 64
+#define SERVER_READ_CHUNK (64 << 10) // Bytes de um pedido lidos de cada vez
+
+typedef struct
+{
+    const CompilerOptions *options;
+    size_t max_source; // Tamanho máximo do código-fonte de um pedido
+
+    pthread_mutex_t lock;
+    pthread_cond_t idle; // Sinalizado quando a última conexão termina
+
+    int *connections; // Descritores das conexões abertas
+    int connection_count;
+    int connection_capacity;
+
+    CompilerContext **contexts; // Contextos livres, prontos para outro pedido
+    int context_count;
+    int context_capacity;
+} Server;
+
+typedef struct
+{
+    Server *server;
+    int fd;
+    CompilerContext *context; // Contexto da última compilação, mantido para os pedidos edit
+} Connection;
+
+// Os sinais são do processo, então só um servidor pode ser interrompido por eles
+static volatile sig_atomic_t server_stopping;
+
+static void server_stop(int signal)
+{
+    (void)signal;
+    server_stopping = 1;
+}
+
+/* Contextos */
+
+static CompilerContext *context_acquire(Server *server)
+{
+    CompilerContext *context = NULL;
+
+    pthread_mutex_lock(&server->lock);
+
+    if (server->context_count > 0)
+    {
+        context = server->contexts[--server->context_count];
+    }
+
+    pthread_mutex_unlock(&server->lock);
+
+    if (context == NULL)
+    {
+        context = (CompilerContext *)checked_realloc(NULL, sizeof(CompilerContext), "Error allocating server state");
+        compiler_context_init(context);
+    }
+
+    return context;
+}
+
+static void context_release(Server *server, CompilerContext *context)
+{
+    pthread_mutex_lock(&server->lock);
+
+    if (server->context_count == server->context_capacity)
+    {
+        server->context_capacity = server->context_capacity ? server->context_capacity * 2 : 8;
+        server->contexts = (CompilerContext **)checked_realloc(server->contexts, server->context_capacity * sizeof(CompilerContext *), "Error allocating server state");
+    }
+
+    server->contexts[server->context_count++] = context;
+
+    pthread_mutex_unlock(&server->lock);
+}
+
+/* Conexões */
+
+static bool send_all(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += sent;
+        size -= sent;
+    }
+
+    return true;
+}
+
+static bool server_respond(int fd, const char *status, const char *data, size_t size)
+{
+    char header[64];
+    int length = snprintf(header, sizeof(header), "%s %zu\n", status, size);
+
+    return send_all(fd, header, length) && send_all(fd, data, size);
+}
+
+/**
+ * Retira a conexão da lista de conexões abertas, antes de o descritor ser fechado.
+ */
+static void connection_remove(Server *server, int fd)
+{
+    pthread_mutex_lock(&server->lock);
+
+    for (int i = 0; i < server->connection_count; i++)
+    {
+        if (server->connections[i] == fd)
+        {
+            server->connections[i] = server->connections[--server->connection_count];
+            break;
+        }
+    }
+
+    if (server->connection_count == 0)
+    {
+        pthread_cond_signal(&server->idle);
+    }
+
+    pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * Lê count números separados por espaços, que devem ocupar todo o texto.
+ * Os tokens guardam offsets de 32 bits, então números maiores são inválidos.
+ */
+static bool parse_numbers(const char *text, uint32_t *values, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        char *end;
+        unsigned long long value = strtoull(text, &end, 10);
+
+        if (end == text || *text == ' ' || *text == '-' || value > UINT32_MAX || *end != (i + 1 < count ? ' ' : '\0'))
+        {
+            return false;
+        }
+
+        values[i] = (uint32_t)value;
+        text = end + 1;
+    }
+
+    return true;
+}
+
+/**
+ * Lê os size bytes que seguem a linha do pedido. A memória cresce com os bytes
+ * recebidos, e não com o tamanho anunciado, que pode não chegar.
+ * @return Memória alocada com malloc, ou NULL se a conexão terminar antes.
+ */
+static char *read_payload(FILE *input, size_t size)
+{
+    char *data = NULL;
+    size_t capacity = 0;
+    size_t length = 0;
+
+    do
+    {
+        size_t chunk = size - length < SERVER_READ_CHUNK ? size - length : SERVER_READ_CHUNK;
+
+        if (length + chunk + 1 > capacity)
+        {
+            capacity = capacity ? capacity * 2 : SERVER_READ_CHUNK;
+            capacity = capacity < size + 1 ? capacity : size + 1;
+            data = (char *)checked_realloc(data, capacity, "Error allocating server state");
+        }
+
+        if (fread(data + length, 1, chunk, input) != chunk)
+        {
+            free(data);
+            return NULL;
+        }
+
+        length += chunk;
+    } while (length < size);
+
+    return data;
+}
+
+/**
+ * Descarta os size bytes que seguem a linha de um pedido recusado.
+ * @return false se a conexão terminar antes.
+ */
+static bool skip_payload(FILE *input, size_t size)
+{
+    char buffer[4096];
+
+    while (size > 0)
+    {
+        size_t chunk = size < sizeof(buffer) ? size : sizeof(buffer);
+
+        if (fread(buffer, 1, chunk, input) != chunk)
+        {
+            return false;
+        }
+
+        size -= chunk;
+    }
+
+    return true;
+}
+
+/**
+ * Analisa o arquivo filename, o código-fonte em source ou, se edit não for
+ * NULL, a edição {offset, removed} do código-fonte da última compilação da
+ * conexão, com os bytes de source inseridos. Responde com os diagnósticos.
+ */
+static bool server_compile(Connection *connection, const char *filename, char *source, size_t size, const uint32_t *edit)
+{
+    Server *server = connection->server;
+    char *diagnostics = NULL;
+    size_t diagnostics_size = 0;
+    FILE *output = open_memstream(&diagnostics, &diagnostics_size);
+    struct stat info;
+    bool success;
+
+    if (output == NULL)
+    {
+        perror("Error allocating diagnostics");
+        exit(EXIT_FAILURE);
+    }
+
+    // Os erros de abertura do arquivo vão para o cliente, e não para a saída de erros do servidor
+    if (filename != NULL && stat(filename, &info) < 0)
+    {
+        fprintf(output, "Error opening source file: %s\n", strerror(errno));
+        success = false;
+    }
+    else
+    {
+        if (connection->context == NULL)
+        {
+            connection->context = context_acquire(server);
+        }
+
+        CompilerContext *context = connection->context;
+
+        context->options = *server->options;
+        context->options.sink = &log_sink_null;
+        context->options.echo = false;
+        context->options.output = output;
+
+        if (edit != NULL)
+        {
+            success = compiler_edit(context, edit[0], edit[1], source, size);
+            free(source);
+        }
+        else
+        {
+            success = filename != NULL ? compiler_compile(context, filename) : compiler_compile_source(context, source, size);
+        }
+    }
+
+    fclose(output);
+
+    bool sent = server_respond(connection->fd, success ? "ok" : "failed", diagnostics, diagnostics_size);
+
+    free(diagnostics);
+    return sent;
+}
+
+/**
+ * Responde a um pedido edit que não pode ser aplicado, descartando os seus bytes.
+ * @return false se a conexão terminou.
+ */
+static bool server_reject_edit(Connection *connection, const char *message, char *text)
+{
+    free(text);
+    return server_respond(connection->fd, "error", message, strlen(message));
+}
+
+/**
+ * Responde a um pedido maior que max_source sem ler os seus bytes para a memória.
+ * @return false se a conexão terminou.
+ */
+static bool server_reject_size(Connection *connection, FILE *input, size_t size)
+{
+    const char *message = "source too large\n";
+
+    return skip_payload(input, size) && server_respond(connection->fd, "error", message, strlen(message));
+}
+
+/**
+ * Atende os pedidos de uma conexão até o cliente fechá-la ou enviar um pedido incompleto.
+ */
+static void *server_connection(void *argument)
+{
+    Connection *connection = (Connection *)argument;
+    Server *server = connection->server;
+    int fd = connection->fd;
+    FILE *input = fdopen(fd, "r");
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    bool connected = input != NULL;
+
+    while (connected && (length = getline(&line, &capacity, input)) > 0)
+    {
+        if (line[length - 1] == '\n')
+        {
+            line[--length] = '\0';
+        }
+
+        if (strncmp(line, "check ", 6) == 0)
+        {
+            // "-" seria a entrada padrão do próprio servidor
+            if (strcmp(line + 6, "-") == 0)
+            {
+                const char *message = "invalid path\n";
+                connected = server_respond(fd, "error", message, strlen(message));
+            }
+            else
+            {
+                connected = server_compile(connection, line + 6, NULL, 0, NULL);
+            }
+        }
+        else if (strncmp(line, "source ", 7) == 0)
+        {
+            uint32_t size;
+
+            if (!parse_numbers(line + 7, &size, 1))
+            {
+                const char *message = "invalid source size\n";
+                server_respond(fd, "error", message, strlen(message));
+                break;
+            }
+
+            if (size > server->max_source)
+            {
+                connected = server_reject_size(connection, input, size);
+                continue;
+            }
+
+            char *source = read_payload(input, size);
+
+            if (source == NULL)
+            {
+                break;
+            }
+
+            connected = server_compile(connection, NULL, source, size, NULL);
+        }
+        else if (strncmp(line, "edit ", 5) == 0)
+        {
+            uint32_t values[3]; // offset, removidos, inseridos
+
+            if (!parse_numbers(line + 5, values, 3))
+            {
+                const char *message = "invalid edit\n";
+                server_respond(fd, "error", message, strlen(message));
+                break;
+            }
+
+            const CompilerContext *context = connection->context;
+            size_t source_size = context != NULL && context->editable ? context->scanner.source_size : 0;
+
+            // O código-fonte editado também fica dentro do limite
+            if (values[2] > server->max_source || (values[1] <= source_size && source_size - values[1] > server->max_source - values[2]))
+            {
+                connected = server_reject_size(connection, input, values[2]);
+                continue;
+            }
+
+            char *text = read_payload(input, values[2]);
+
+            if (text == NULL)
+            {
+                break;
+            }
+
+            if (context == NULL || !context->editable)
+            {
+                connected = server_reject_edit(connection, "no source to edit\n", text);
+            }
+            else if (values[0] > context->scanner.source_size || values[1] > context->scanner.source_size - values[0])
+            {
+                connected = server_reject_edit(connection, "edit out of range\n", text);
+            }
+            else
+            {
+                connected = server_compile(connection, NULL, text, values[2], values);
+            }
+        }
+        else
+        {
+            const char *message = "unknown request\n";
+            connected = server_respond(fd, "error", message, strlen(message));
+        }
+    }
+
+    free(line);
+
+    if (connection->context != NULL)
+    {
+        context_release(server, connection->context);
+    }
+
+    free(connection);
+    connection_remove(server, fd);
+
+    if (input != NULL)
+    {
+        fclose(input);
+    }
+    else
+    {
+        close(fd);
+    }
+
+    return NULL;
+}
+
+/**
+ * Inicia a thread de uma conexão aceita.
+ */
+static void server_accept(Server *server, int fd)
+{
+    Connection *connection = (Connection *)checked_realloc(NULL, sizeof(Connection), "Error allocating server state");
+    pthread_attr_t attributes;
+    pthread_t thread;
+    sigset_t signals, previous;
+
+    *connection = (Connection){server, fd, NULL};
+
+    pthread_mutex_lock(&server->lock);
+
+    if (server->connection_count == server->connection_capacity)
+    {
+        server->connection_capacity = server->connection_capacity ? server->connection_capacity * 2 : 16;
+        server->connections = (int *)checked_realloc(server->connections, server->connection_capacity * sizeof(int), "Error allocating server state");
+    }
+
+    server->connections[server->connection_count++] = fd;
+
+    pthread_mutex_unlock(&server->lock);
+
+    // As threads das conexões herdam os sinais bloqueados, então SIGINT e SIGTERM interrompem o accept da thread principal
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create(&thread, &attributes, server_connection, connection) != 0)
+    {
+        perror("Error starting connection thread");
+        connection_remove(server, fd);
+        close(fd);
+        free(connection);
+    }
+
+    pthread_attr_destroy(&attributes);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+bool server_run(const char *socket_path, const CompilerOptions *options, size_t max_source)
+{
+    struct sockaddr_un address = {0};
+
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return false;
+    }
+
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0)
+    {
+        perror("Error creating server socket");
+        return false;
+    }
+
+    unlink(socket_path);
+
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listener, SERVER_BACKLOG) < 0)
+    {
+        perror("Error binding server socket");
+        close(listener);
+        return false;
+    }
+
+    // Sem SA_RESTART: o sinal interrompe o accept
+    struct sigaction action = {0};
+    action.sa_handler = server_stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    Server server = {0};
+    server.options = options;
+    server.max_source = max_source;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.idle, NULL);
+
+    server_stopping = 0;
+
+    while (!server_stopping)
+    {
+        int fd = accept(listener, NULL, NULL);
+
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+
+            perror("Error accepting connection");
+            break;
+        }
+
+        server_accept(&server, fd);
+    }
+
+    close(listener);
+    unlink(socket_path);
+
+    // As conexões abertas terminam o pedido em andamento e são fechadas
+    pthread_mutex_lock(&server.lock);
+
+    for (int i = 0; i < server.connection_count; i++)
+    {
+        shutdown(server.connections[i], SHUT_RD);
+    }
+
+    while (server.connection_count > 0)
+    {
+        pthread_cond_wait(&server.idle, &server.lock);
+    }
+
+    pthread_mutex_unlock(&server.lock);
+
+    for (int i = 0; i < server.context_count; i++)
+    {
+        compiler_context_free(server.contexts[i]);
+        free(server.contexts[i]);
+    }
+
+    free(server.contexts);
+    free(server.connections);
+    pthread_cond_destroy(&server.idle);
+    pthread_mutex_destroy(&server.lock);
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    return true;
+}
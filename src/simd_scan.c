@@ -0,0 +1,319 @@
+#include "simd_scan.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86 1
+#endif
+
+static inline bool is_whitespace(unsigned char ch)
+{
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+static const char *skip_whitespace_scalar(const char *p, const char *end)
+{
+    while (p < end && is_whitespace(*p))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static const char *find_comment_end_scalar(const char *p, const char *end)
+{
+    while (p < end)
+    {
+        if (*p == '*' && p + 1 < end && p[1] == '/')
+        {
+            return p;
+        }
+
+        p++;
+    }
+
+    return NULL;
+}
+
+static size_t count_newlines_scalar(const char *p, const char *end)
+{
+    size_t count = 0;
+
+    while (p < end)
+    {
+        count += *p++ == '\n';
+    }
+
+    return count;
+}
+
+static size_t collect_newlines_scalar(const char *start, const char *p, const char *end, uint32_t *positions)
+{
+    size_t count = 0;
+
+    for (; p < end; p++)
+    {
+        if (*p == '\n')
+        {
+            positions[count++] = p - start;
+        }
+    }
+
+    return count;
+}
+
+#ifdef SIMD_SCAN_X86
+
+/* Máscara dos bytes que são espaço em branco: ' ' ou '\t' ... '\r' */
+static inline unsigned whitespace_mask_sse2(__m128i chunk)
+{
+    __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+    __m128i space = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+
+    return _mm_movemask_epi8(_mm_or_si128(control, space));
+}
+
+static const char *skip_whitespace_sse2(const char *p, const char *end)
+{
+    while (end - p >= 16)
+    {
+        unsigned blank = whitespace_mask_sse2(_mm_loadu_si128((const __m128i *)p));
+
+        if (blank != 0xFFFF)
+        {
+            return p + __builtin_ctz(~blank);
+        }
+
+        p += 16;
+    }
+
+    return skip_whitespace_scalar(p, end);
+}
+
+static const char *find_comment_end_sse2(const char *p, const char *end)
+{
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+
+    // O byte seguinte a cada posição também é lido, daí o limite de 17 bytes
+    while (end - p >= 17)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+        __m128i next = _mm_loadu_si128((const __m128i *)(p + 1));
+        unsigned closing = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(chunk, star), _mm_cmpeq_epi8(next, slash)));
+
+        if (closing != 0)
+        {
+            return p + __builtin_ctz(closing);
+        }
+
+        p += 16;
+    }
+
+    return find_comment_end_scalar(p, end);
+}
+
+static size_t count_newlines_sse2(const char *p, const char *end)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        p += 16;
+    }
+
+    return count + count_newlines_scalar(p, end);
+}
+
+static size_t collect_newlines_sse2(const char *start, const char *p, const char *end, uint32_t *positions)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+
+    while (end - p >= 16)
+    {
+        unsigned breaks = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), newline));
+
+        while (breaks != 0)
+        {
+            positions[count++] = (p - start) + __builtin_ctz(breaks);
+            breaks &= breaks - 1;
+        }
+
+        p += 16;
+    }
+
+    return count + collect_newlines_scalar(start, p, end, positions + count);
+}
+
+__attribute__((target("avx2"))) static const char *skip_whitespace_avx2(const char *p, const char *end)
+{
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i control_range = _mm256_set1_epi8('\r' - '\t');
+    const __m256i space = _mm256_set1_epi8(' ');
+
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+        __m256i shifted = _mm256_sub_epi8(chunk, tab);
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, control_range), shifted);
+        unsigned blank = _mm256_movemask_epi8(_mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, space)));
+
+        if (blank != 0xFFFFFFFFu)
+        {
+            return p + __builtin_ctz(~blank);
+        }
+
+        p += 32;
+    }
+
+    return skip_whitespace_sse2(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *find_comment_end_avx2(const char *p, const char *end)
+{
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+
+    while (end - p >= 33)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+        __m256i next = _mm256_loadu_si256((const __m256i *)(p + 1));
+        unsigned closing = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(chunk, star), _mm256_cmpeq_epi8(next, slash)));
+
+        if (closing != 0)
+        {
+            return p + __builtin_ctz(closing);
+        }
+
+        p += 32;
+    }
+
+    return find_comment_end_sse2(p, end);
+}
+
+__attribute__((target("avx2"))) static size_t count_newlines_avx2(const char *p, const char *end)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+        count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        p += 32;
+    }
+
+    return count + count_newlines_sse2(p, end);
+}
+
+__attribute__((target("avx2"))) static size_t collect_newlines_avx2(const char *start, const char *p, const char *end, uint32_t *positions)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+
+    while (end - p >= 32)
+    {
+        unsigned breaks = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), newline));
+
+        while (breaks != 0)
+        {
+            positions[count++] = (p - start) + __builtin_ctz(breaks);
+            breaks &= breaks - 1;
+        }
+
+        p += 32;
+    }
+
+    return count + collect_newlines_sse2(start, p, end, positions + count);
+}
+
+#endif // SIMD_SCAN_X86
+
+typedef struct
+{
+    const char *(*skip_whitespace)(const char *, const char *);
+    const char *(*find_comment_end)(const char *, const char *);
+    size_t (*count_newlines)(const char *, const char *);
+    size_t (*collect_newlines)(const char *, const char *, const char *, uint32_t *);
+} ScanFunctions;
+
+static const ScanFunctions scalar_functions = {
+    skip_whitespace_scalar, find_comment_end_scalar, count_newlines_scalar, collect_newlines_scalar};
+
+#ifdef SIMD_SCAN_X86
+static const ScanFunctions sse2_functions = {
+    skip_whitespace_sse2, find_comment_end_sse2, count_newlines_sse2, collect_newlines_sse2};
+
+static const ScanFunctions avx2_functions = {
+    skip_whitespace_avx2, find_comment_end_avx2, count_newlines_avx2, collect_newlines_avx2};
+#endif
+
+static const ScanFunctions *scan_functions;
+
+/**
+ * Escolhe as implementações de acordo com a CPU. Pode ser executada por várias
+ * threads ao mesmo tempo: todas escrevem o mesmo ponteiro.
+ */
+static const ScanFunctions *select_functions()
+{
+    const ScanFunctions *selected = __atomic_load_n(&scan_functions, __ATOMIC_ACQUIRE);
+
+    if (selected != NULL)
+    {
+        return selected;
+    }
+
+    selected = &scalar_functions;
+
+#ifdef SIMD_SCAN_X86
+    selected = &sse2_functions;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        selected = &avx2_functions;
+    }
+#endif
+
+    __atomic_store_n(&scan_functions, selected, __ATOMIC_RELEASE);
+    return selected;
+}
+
+const char *simd_skip_whitespace(const char *start, const char *end)
+{
+    // Caso comum: um único espaço (ou nenhum) entre dois tokens
+    if (start == end || !is_whitespace(*start))
+    {
+        return start;
+    }
+
+    if (start + 1 < end && !is_whitespace(start[1]))
+    {
+        return start + 1;
+    }
+
+    return select_functions()->skip_whitespace(start, end);
+}
+
+const char *simd_find_comment_end(const char *start, const char *end)
+{
+    return select_functions()->find_comment_end(start, end);
+}
+
+size_t simd_count_newlines(const char *start, const char *end)
+{
+    return select_functions()->count_newlines(start, end);
+}
+
+size_t simd_collect_newlines(const char *start, const char *end, uint32_t *positions)
+{
+    return select_functions()->collect_newlines(start, start, end, positions);
+}
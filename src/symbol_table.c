@@ -0,0 +1,165 @@
+#include "symbol_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocation.h"
+
+static uint32_t hash_name(const char *name, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Procura a posição do nome na tabela: a posição ocupada pelo símbolo ou a
+ * primeira posição vazia da sequência de sondagem.
+ */
+static uint32_t find_slot(const SymbolTable *table, const char *name, size_t length, uint32_t hash)
+{
+    uint32_t mask = table->slot_count - 1;
+    uint32_t slot = hash & mask;
+
+    while (table->slots[slot] != 0)
+    {
+        uint32_t symbol = table->slots[slot] - 1;
+
+        if (table->hashes[symbol] == hash && table->lengths[symbol] == length &&
+            memcmp(table->names + table->offsets[symbol], name, length) == 0)
+        {
+            break;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static void grow_slots(SymbolTable *table)
+{
+    uint32_t new_count = table->slot_count * 2;
+    uint32_t mask = new_count - 1;
+    uint32_t *new_slots = (uint32_t *)calloc(new_count, sizeof(uint32_t));
+
+    if (new_slots == NULL)
+    {
+        perror("Error allocating symbol table");
+        exit(EXIT_FAILURE);
+    }
+
+    // Os hashes já estão guardados, então não é preciso reler os nomes
+    for (uint32_t symbol = 0; symbol < table->count; symbol++)
+    {
+        uint32_t slot = table->hashes[symbol] & mask;
+
+        while (new_slots[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        new_slots[slot] = symbol + 1;
+    }
+
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_count = new_count;
+}
+
+void symbol_table_init(SymbolTable *table)
+{
+    memset(table, 0, sizeof(*table));
+
+    table->slot_count = SYMBOL_TABLE_INITIAL_SLOTS;
+    table->slots = (uint32_t *)calloc(table->slot_count, sizeof(uint32_t));
+
+    table->names_capacity = SYMBOL_TABLE_INITIAL_NAMES;
+    table->names = (char *)malloc(table->names_capacity);
+
+    if (table->slots == NULL || table->names == NULL)
+    {
+        perror("Error allocating symbol table");
+        exit(EXIT_FAILURE);
+    }
+}
+
+uint32_t symbol_table_intern(SymbolTable *table, const char *name, size_t length)
+{
+    uint32_t hash = hash_name(name, length);
+    uint32_t slot = find_slot(table, name, length, hash);
+
+    if (table->slots[slot] != 0)
+    {
+        return table->slots[slot] - 1;
+    }
+
+    if (table->count == table->capacity)
+    {
+        table->capacity = table->capacity ? table->capacity * 2 : SYMBOL_TABLE_INITIAL_SLOTS;
+        table->hashes = (uint32_t *)checked_realloc(table->hashes, table->capacity * sizeof(uint32_t), "Error allocating symbol table");
+        table->offsets = (uint32_t *)checked_realloc(table->offsets, table->capacity * sizeof(uint32_t), "Error allocating symbol table");
+        table->lengths = (uint32_t *)checked_realloc(table->lengths, table->capacity * sizeof(uint32_t), "Error allocating symbol table");
+    }
+
+    while (table->names_size + length + 1 > table->names_capacity)
+    {
+        table->names_capacity *= 2;
+        table->names = (char *)checked_realloc(table->names, table->names_capacity, "Error allocating symbol table");
+    }
+
+    uint32_t symbol = table->count++;
+
+    table->hashes[symbol] = hash;
+    table->offsets[symbol] = table->names_size;
+    table->lengths[symbol] = length;
+
+    memcpy(table->names + table->names_size, name, length);
+    table->names[table->names_size + length] = '\0';
+    table->names_size += length + 1;
+
+    table->slots[slot] = symbol + 1;
+
+    if (table->count * 4 >= table->slot_count * 3)
+    {
+        grow_slots(table);
+    }
+
+    return symbol;
+}
+
+uint32_t symbol_table_find(const SymbolTable *table, const char *name, size_t length)
+{
+    uint32_t slot = find_slot(table, name, length, hash_name(name, length));
+
+    return table->slots[slot] == 0 ? SYMBOL_NONE : table->slots[slot] - 1;
+}
+
+const char *symbol_table_name(const SymbolTable *table, uint32_t symbol)
+{
+    return table->names + table->offsets[symbol];
+}
+
+void symbol_table_clear(SymbolTable *table)
+{
+    memset(table->slots, 0, table->slot_count * sizeof(uint32_t));
+    table->count = 0;
+    table->names_size = 0;
+}
+
+void symbol_table_free(SymbolTable *table)
+{
+    free(table->slots);
+    free(table->hashes);
+    free(table->offsets);
+    free(table->lengths);
+    free(table->names);
+    memset(table, 0, sizeof(*table));
+}
@@ -1,14 +1,16 @@
-#include <stdlib.h>
-#include <string.h>
-
 #include "token.h"
 
+#include "symbol_table.h"
+
 const char *keywords[] = {
     "program", "begin", "end", "procedure", "function", "if", "then", "else", "while", "do",
     "and", "or", "not", "var", "integer", "boolean", "true", "false", "write", "div"};
 
 const int num_keywords = sizeof(keywords) / sizeof(keywords[0]);
 
+const char *booleans[] = {"true", "false"};
+const int num_booleans = sizeof(booleans) / sizeof(booleans[0]);
+
 const char *arithmetic_operators[] = {"+", "-", "*", "div"};
 const int num_arithmetic_operators = sizeof(arithmetic_operators) / sizeof(arithmetic_operators[0]);
 
@@ -21,6 +23,20 @@ const int num_logical_operators = sizeof(logical_operators) / sizeof(logical_ope
 const char *delimiters[] = {"(", ")", ",", ":", ".", ";"};
 const int num_delimiters = sizeof(delimiters) / sizeof(delimiters[0]);
 
+const TokenKind keyword_kinds[] = {
+    KW_PROGRAM, KW_BEGIN, KW_END, KW_PROCEDURE, KW_FUNCTION, KW_IF, KW_THEN, KW_ELSE, KW_WHILE, KW_DO,
+    OP_AND, OP_OR, OP_NOT, KW_VAR, KW_INTEGER, KW_BOOLEAN, BOOL_TRUE, BOOL_FALSE, KW_WRITE, OP_DIV};
+
+const TokenKind boolean_kinds[] = {BOOL_TRUE, BOOL_FALSE};
+
+const TokenKind arithmetic_operator_kinds[] = {OP_PLUS, OP_MINUS, OP_TIMES, OP_DIV};
+
+const TokenKind relational_operator_kinds[] = {REL_EQ, REL_NE, REL_LT, REL_LE, REL_GT, REL_GE};
+
+const TokenKind logical_operator_kinds[] = {OP_AND, OP_OR, OP_NOT};
+
+const TokenKind delimiter_kinds[] = {DELIM_LPAREN, DELIM_RPAREN, DELIM_COMMA, DELIM_COLON, DELIM_DOT, DELIM_SEMI};
+
 const char *token_type_to_string(TokenType type)
 {
     switch (type)
@@ -49,20 +65,69 @@ const char *token_type_to_string(TokenType type)
         return "DELIMITER";
     case TOKEN_COMMENT:
         return "COMMENT";
+    case TOKEN_EOF:
+        return "EOF";
     default:
         return "UNKNOWN";
     }
 }
 
-Token *create_token(TokenType type, const char *start, const char *end, int line)
+const char *token_kind_to_string(TokenKind kind)
 {
-    Token *token = (Token *)malloc(sizeof(Token));
-    token->type = type;
+    static const char *const names[TOKEN_KIND_COUNT] = {
+        [KW_PROGRAM] = "KW_PROGRAM",
+        [KW_BEGIN] = "KW_BEGIN",
+        [KW_END] = "KW_END",
+        [KW_PROCEDURE] = "KW_PROCEDURE",
+        [KW_FUNCTION] = "KW_FUNCTION",
+        [KW_IF] = "KW_IF",
+        [KW_THEN] = "KW_THEN",
+        [KW_ELSE] = "KW_ELSE",
+        [KW_WHILE] = "KW_WHILE",
+        [KW_DO] = "KW_DO",
+        [KW_VAR] = "KW_VAR",
+        [KW_INTEGER] = "KW_INTEGER",
+        [KW_BOOLEAN] = "KW_BOOLEAN",
+        [KW_WRITE] = "KW_WRITE",
+        [BOOL_TRUE] = "BOOL_TRUE",
+        [BOOL_FALSE] = "BOOL_FALSE",
+        [OP_PLUS] = "OP_PLUS",
+        [OP_MINUS] = "OP_MINUS",
+        [OP_TIMES] = "OP_TIMES",
+        [OP_DIV] = "OP_DIV",
+        [REL_EQ] = "REL_EQ",
+        [REL_NE] = "REL_NE",
+        [REL_LT] = "REL_LT",
+        [REL_LE] = "REL_LE",
+        [REL_GT] = "REL_GT",
+        [REL_GE] = "REL_GE",
+        [OP_AND] = "OP_AND",
+        [OP_OR] = "OP_OR",
+        [OP_NOT] = "OP_NOT",
+        [OP_ASSIGN] = "OP_ASSIGN",
+        [DELIM_LPAREN] = "DELIM_LPAREN",
+        [DELIM_RPAREN] = "DELIM_RPAREN",
+        [DELIM_COMMA] = "DELIM_COMMA",
+        [DELIM_COLON] = "DELIM_COLON",
+        [DELIM_DOT] = "DELIM_DOT",
+        [DELIM_SEMI] = "DELIM_SEMI",
+    };
 
-    token->value = (char *)malloc(end - start + 1);
-    strncpy(token->value, start, end - start);
-    token->value[end - start] = '\0';
+    if (kind < 0 || kind >= TOKEN_KIND_COUNT)
+    {
+        return "TOKEN_KIND_NONE";
+    }
 
-    token->line = line;
+    return names[kind];
+}
+
+Token create_token(TokenType type, TokenKind kind, uint32_t offset, uint32_t length)
+{
+    Token token;
+    token.type = type;
+    token.kind = kind;
+    token.offset = offset;
+    token.length = length;
+    token.symbol = SYMBOL_NONE;
     return token;
-}
\ No newline at end of file
+}
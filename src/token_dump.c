@@ -0,0 +1,189 @@
+#include "token_dump.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Registra por que o log é inválido e desfaz o mapeamento.
+ * @return false, para ser devolvido por token_dump_open.
+ */
+static bool invalid_dump(TokenDump *dump, const char *filename, const char *reason)
+{
+    fprintf(stderr, "Invalid token dump %s: %s\n", filename, reason);
+    token_dump_close(dump);
+    return false;
+}
+
+/**
+ * @return Se o registro tem um TokenType que o scanner registra e um TokenKind
+ *         coerente com ele, já que o parser indexa tabelas pelo TokenKind.
+ */
+static bool valid_record(const TokenDumpRecord *record)
+{
+    if (record->type < TOKEN_NUMBER || record->type > TOKEN_EOF || record->kind < TOKEN_KIND_NONE || record->kind >= TOKEN_KIND_COUNT)
+    {
+        return false;
+    }
+
+    // Só palavras reservadas, booleanos, operadores e delimitadores têm um lexema específico
+    bool has_kind = record->type != TOKEN_NUMBER && record->type != TOKEN_IDENTIFIER && record->type != TOKEN_COMMENT && record->type != TOKEN_EOF;
+
+    return has_kind == (record->kind != TOKEN_KIND_NONE);
+}
+
+bool token_dump_open(TokenDump *dump, const char *filename)
+{
+    memset(dump, 0, sizeof(*dump));
+
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("Error opening token dump");
+        return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) < 0)
+    {
+        perror("Error opening token dump");
+        close(fd);
+        return false;
+    }
+
+    if ((size_t)info.st_size < sizeof(TokenDumpHeader))
+    {
+        close(fd);
+        return invalid_dump(dump, filename, "truncated header");
+    }
+
+    void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        perror("Error mapping token dump");
+        return false;
+    }
+
+    dump->data = (const char *)mapping;
+    dump->size = info.st_size;
+
+    const TokenDumpHeader *header = (const TokenDumpHeader *)dump->data;
+
+    if (memcmp(header->magic, TOKEN_DUMP_MAGIC, 4) != 0)
+    {
+        return invalid_dump(dump, filename, "not a token dump");
+    }
+
+    if (header->version != TOKEN_DUMP_VERSION)
+    {
+        return invalid_dump(dump, filename, "unsupported version");
+    }
+
+    // Os limites são verificados em 64 bits, então nenhuma soma transborda
+    uint64_t records_end = header->records_offset + (uint64_t)header->record_count * sizeof(TokenDumpRecord);
+    uint64_t strings_end = header->strings_offset + (uint64_t)header->string_count * 2 * sizeof(uint32_t);
+
+    if (header->records_offset % sizeof(uint32_t) != 0 || header->strings_offset % sizeof(uint32_t) != 0 ||
+        records_end > dump->size || strings_end > dump->size || header->names_size > dump->size - strings_end)
+    {
+        return invalid_dump(dump, filename, "sections out of bounds");
+    }
+
+    dump->records = (const TokenDumpRecord *)(dump->data + header->records_offset);
+    dump->record_count = header->record_count;
+    dump->string_offsets = (const uint32_t *)(dump->data + header->strings_offset);
+    dump->string_lengths = dump->string_offsets + header->string_count;
+    dump->string_count = header->string_count;
+    dump->names = dump->data + strings_end;
+
+    for (uint32_t i = 0; i < dump->string_count; i++)
+    {
+        if ((uint64_t)dump->string_offsets[i] + dump->string_lengths[i] >= header->names_size)
+        {
+            return invalid_dump(dump, filename, "string out of bounds");
+        }
+    }
+
+    for (uint32_t i = 0; i < dump->record_count; i++)
+    {
+        if (!valid_record(&dump->records[i]))
+        {
+            return invalid_dump(dump, filename, "invalid token type or kind");
+        }
+
+        if (dump->records[i].string >= dump->string_count && dump->records[i].type != TOKEN_EOF)
+        {
+            return invalid_dump(dump, filename, "string out of bounds");
+        }
+    }
+
+    // A análise do código-fonte foi interrompida antes do fim (por exemplo, por um erro léxico)
+    if (dump->record_count == 0 || dump->records[dump->record_count - 1].type != TOKEN_EOF)
+    {
+        return invalid_dump(dump, filename, "incomplete token stream");
+    }
+
+    return true;
+}
+
+void token_dump_load(const TokenDump *dump, TokenStream *stream)
+{
+    for (uint32_t i = 0; i < dump->record_count; i++)
+    {
+        const TokenDumpRecord *record = &dump->records[i];
+
+        if (record->type == TOKEN_COMMENT)
+        {
+            continue;
+        }
+
+        Token token = create_token(record->type, record->kind, record->offset, record->length);
+        token.symbol = record->string;
+        token_stream_push(stream, &token);
+    }
+}
+
+const TokenDumpRecord *token_dump_find(const TokenDump *dump, uint32_t offset)
+{
+    uint32_t low = 0;
+    uint32_t high = dump->record_count;
+
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+
+        if (dump->records[middle].offset < offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low < dump->record_count && dump->records[low].offset == offset ? &dump->records[low] : NULL;
+}
+
+const char *token_dump_string(const TokenDump *dump, uint32_t string)
+{
+    return dump->names + dump->string_offsets[string];
+}
+
+void token_dump_close(TokenDump *dump)
+{
+    if (dump->data != NULL)
+    {
+        munmap((void *)dump->data, dump->size);
+    }
+
+    memset(dump, 0, sizeof(*dump));
+}
@@ -0,0 +1,50 @@
+#include "token_stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocation.h"
+
+void token_stream_init(TokenStream *stream)
+{
+    memset(stream, 0, sizeof(*stream));
+}
+
+void token_stream_push(TokenStream *stream, const Token *token)
+{
+    if (stream->count == stream->capacity)
+    {
+        stream->capacity = stream->capacity ? stream->capacity * 2 : TOKEN_STREAM_INITIAL_CAPACITY;
+        stream->types = (uint8_t *)checked_realloc(stream->types, stream->capacity * sizeof(uint8_t), "Error allocating token stream");
+        stream->kinds = (int16_t *)checked_realloc(stream->kinds, stream->capacity * sizeof(int16_t), "Error allocating token stream");
+        stream->offsets = (uint32_t *)checked_realloc(stream->offsets, stream->capacity * sizeof(uint32_t), "Error allocating token stream");
+        stream->lengths = (uint32_t *)checked_realloc(stream->lengths, stream->capacity * sizeof(uint32_t), "Error allocating token stream");
+        stream->symbols = (uint32_t *)checked_realloc(stream->symbols, stream->capacity * sizeof(uint32_t), "Error allocating token stream");
+    }
+
+    uint32_t index = stream->count++;
+
+    stream->types[index] = token->type;
+    stream->kinds[index] = token->kind;
+    stream->offsets[index] = token->offset;
+    stream->lengths[index] = token->length;
+    stream->symbols[index] = token->symbol;
+}
+
+Token token_stream_get(const TokenStream *stream, uint32_t index)
+{
+    Token token = create_token(stream->types[index], stream->kinds[index], stream->offsets[index], stream->lengths[index]);
+    token.symbol = stream->symbols[index];
+    return token;
+}
+
+void token_stream_free(TokenStream *stream)
+{
+    free(stream->types);
+    free(stream->kinds);
+    free(stream->offsets);
+    free(stream->lengths);
+    free(stream->symbols);
+    memset(stream, 0, sizeof(*stream));
+}
@@ -0,0 +1,515 @@
+#include "type_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocation.h"
+#include "compiler_context.h"
+
+typedef struct
+{
+    CompilerContext *context;
+    const Ast *ast;
+    TypeTable *table;
+    bool report;
+    bool pending;      // type_check_pending: os erros são guardados com a posição
+    AstIndex index;    // Nó em verificação
+    uint32_t position; // Primeira posição guardada para um nó a partir de index
+    uint32_t errors;
+} TypeChecker;
+
+static const char *const operator_texts[TOKEN_KIND_COUNT] = {
+    [OP_PLUS] = "+",
+    [OP_MINUS] = "-",
+    [OP_TIMES] = "*",
+    [OP_DIV] = "div",
+    [OP_AND] = "and",
+    [OP_OR] = "or",
+    [OP_NOT] = "not",
+    [REL_EQ] = "=",
+    [REL_NE] = "<>",
+    [REL_LT] = "<",
+    [REL_LE] = "<=",
+    [REL_GT] = ">",
+    [REL_GE] = ">=",
+};
+
+const char *type_to_string(Type type)
+{
+    switch (type)
+    {
+    case TYPE_INTEGER:
+        return "integer";
+    case TYPE_BOOLEAN:
+        return "boolean";
+    case TYPE_ERROR:
+        return "error";
+    default:
+        return "no value";
+    }
+}
+
+/**
+ * @brief Converte o TokenKind de um tipo declarado (KW_INTEGER ou KW_BOOLEAN).
+ */
+static Type declared_type(TokenKind kind)
+{
+    switch (kind)
+    {
+    case KW_INTEGER:
+        return TYPE_INTEGER;
+    case KW_BOOLEAN:
+        return TYPE_BOOLEAN;
+    default:
+        return TYPE_NONE;
+    }
+}
+
+/**
+ * @brief Guarda um erro da leitura em fluxo, com a posição guardada pelo parser para o
+ *        nó ou calculada agora, enquanto a linha está no índice.
+ */
+static void diagnostic_add(TypeChecker *checker, uint32_t offset, uint32_t span, const char *message)
+{
+    TypeTable *table = checker->table;
+    int max_errors = checker->context->options.max_errors;
+
+    // Depois de max_errors, o próximo erro só interrompe a análise
+    if (max_errors > 0 && table->diagnostic_count > (uint32_t)max_errors)
+    {
+        return;
+    }
+
+    if (table->diagnostic_count == table->diagnostic_capacity)
+    {
+        table->diagnostic_capacity = table->diagnostic_capacity ? table->diagnostic_capacity * 2 : 16;
+        table->diagnostics = (TypeDiagnostic *)checked_realloc(table->diagnostics, table->diagnostic_capacity * sizeof(TypeDiagnostic), "Error allocating type errors");
+    }
+
+    TypeDiagnostic *diagnostic = &table->diagnostics[table->diagnostic_count++];
+    size_t length = strlen(message) + 1;
+
+    diagnostic->offset = offset;
+    diagnostic->span = span;
+    diagnostic->message = (char *)checked_realloc(NULL, length, "Error allocating type errors");
+    memcpy(diagnostic->message, message, length);
+
+    // As posições guardadas e os nós verificados seguem a mesma ordem
+    while (checker->position < table->position_count && table->positions[checker->position].node < checker->index)
+    {
+        checker->position++;
+    }
+
+    if (checker->position < table->position_count && table->positions[checker->position].node == checker->index)
+    {
+        diagnostic->line = table->positions[checker->position].line;
+        diagnostic->column = table->positions[checker->position].column;
+    }
+    else
+    {
+        line_index_locate(&checker->context->scanner.line_index, offset, &diagnostic->line, &diagnostic->column);
+    }
+}
+
+static void type_error(TypeChecker *checker, uint32_t offset, uint32_t span, const char *message)
+{
+    checker->errors++;
+
+    if (checker->report)
+    {
+        parser_semantic_error(checker->context, offset, span, message);
+    }
+    else if (checker->pending)
+    {
+        diagnostic_add(checker, offset, span, message);
+    }
+}
+
+static inline Type child_type(const TypeChecker *checker, AstIndex child)
+{
+    return (Type)checker->table->types[child];
+}
+
+/**
+ * @brief Um identificador usado tem o tipo da declaração resolvida pelo parser. Sem
+ *        declaração (um uso não declarado, ou o nome em uma declaração), o tipo é TYPE_ERROR.
+ */
+static Type identifier_type(const AstNode *node)
+{
+    if (node->flags & AST_FLAG_VARIABLE)
+    {
+        // Um tipo inválido na declaração já foi registrado como erro de sintaxe
+        Type type = declared_type(node->op);
+        return type == TYPE_NONE ? TYPE_ERROR : type;
+    }
+
+    if (node->flags & AST_FLAG_SUBROUTINE)
+    {
+        // Funções valem o resultado, e procedures não têm valor
+        return declared_type(node->op);
+    }
+
+    return TYPE_ERROR;
+}
+
+static Type check_unary(TypeChecker *checker, const AstNode *node)
+{
+    Type expected = node->op == OP_NOT ? TYPE_BOOLEAN : TYPE_INTEGER;
+    Type operand = child_type(checker, node->first);
+
+    if (operand != expected && operand != TYPE_ERROR)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "Operand of '%s' must be %s, found %s", operator_texts[node->op], type_to_string(expected), type_to_string(operand));
+        type_error(checker, node->offset, strlen(operator_texts[node->op]), message);
+    }
+
+    return expected;
+}
+
+/**
+ * @brief O resultado depende só do operador, então um operando errado não gera erros nos nós de fora.
+ */
+static Type check_binary(TypeChecker *checker, const AstNode *node)
+{
+    Type left = child_type(checker, node->first);
+    Type right = child_type(checker, ast_node(checker->ast, node->first)->next);
+    Type operand, result;
+
+    switch (node->op)
+    {
+    case OP_AND:
+    case OP_OR:
+        operand = result = TYPE_BOOLEAN;
+        break;
+
+    case REL_EQ:
+    case REL_NE:
+        // Qualquer tipo com valor, desde que os dois sejam iguais
+        operand = left != TYPE_NONE ? left : right;
+        result = TYPE_BOOLEAN;
+        break;
+
+    case REL_LT:
+    case REL_LE:
+    case REL_GT:
+    case REL_GE:
+        operand = TYPE_INTEGER;
+        result = TYPE_BOOLEAN;
+        break;
+
+    default:
+        operand = result = TYPE_INTEGER;
+        break;
+    }
+
+    if (left == TYPE_ERROR || right == TYPE_ERROR)
+    {
+        return result;
+    }
+
+    if (left != operand || right != operand || operand == TYPE_NONE)
+    {
+        const char *text = operator_texts[node->op];
+        char message[128];
+
+        if (node->op == REL_EQ || node->op == REL_NE)
+        {
+            snprintf(message, sizeof(message), "Operator '%s' expects operands of the same type, found %s and %s", text, type_to_string(left), type_to_string(right));
+        }
+        else
+        {
+            snprintf(message, sizeof(message), "Operator '%s' expects %s operands, found %s and %s", text, type_to_string(operand), type_to_string(left), type_to_string(right));
+        }
+
+        type_error(checker, node->offset, strlen(text), message);
+    }
+
+    return result;
+}
+
+/**
+ * @brief O alvo é uma variável ou, para o resultado, o nome de uma função, e recebe um valor do seu tipo.
+ */
+static void check_assignment(TypeChecker *checker, const AstNode *node)
+{
+    const AstNode *target = ast_node(checker->ast, node->first);
+    Type expected = child_type(checker, node->first);
+    Type value = child_type(checker, target->next);
+    char message[MAX_LOG_LINE];
+
+    if (target->kind != AST_IDENTIFIER || expected == TYPE_ERROR || value == TYPE_ERROR)
+    {
+        return;
+    }
+
+    const char *name = parser_symbol_name(checker->context, target->symbol);
+
+    if (expected == TYPE_NONE)
+    {
+        snprintf(message, sizeof(message), "'%s' is not a variable", name);
+        type_error(checker, target->offset, strlen(name), message);
+    }
+    else if (value != expected)
+    {
+        snprintf(message, sizeof(message), "Cannot assign %s to '%s' of type %s", type_to_string(value), name, type_to_string(expected));
+        type_error(checker, target->offset, strlen(name), message);
+    }
+}
+
+static void check_condition(TypeChecker *checker, const AstNode *node, const char *keyword)
+{
+    Type condition = child_type(checker, node->first);
+
+    if (condition != TYPE_BOOLEAN && condition != TYPE_ERROR)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "Condition of '%s' must be boolean, found %s", keyword, type_to_string(condition));
+        type_error(checker, node->offset, strlen(keyword), message);
+    }
+}
+
+static void check_write(TypeChecker *checker, const AstNode *node)
+{
+    for (AstIndex child = node->first; child != AST_NONE; child = ast_node(checker->ast, child)->next)
+    {
+        const AstNode *argument = ast_node(checker->ast, child);
+
+        if (argument->kind == AST_IDENTIFIER && child_type(checker, child) == TYPE_NONE)
+        {
+            const char *name = parser_symbol_name(checker->context, argument->symbol);
+            char message[MAX_LOG_LINE];
+
+            snprintf(message, sizeof(message), "'%s' has no value to write", name);
+            type_error(checker, argument->offset, strlen(name), message);
+        }
+    }
+}
+
+/**
+ * @brief Uma chamada vale o resultado da função. Os argumentos não são comparados
+ *        com os parâmetros, que não ficam nos escopos.
+ */
+static Type check_call(TypeChecker *checker, const AstNode *node)
+{
+    const AstNode *name = ast_node(checker->ast, node->first);
+
+    if (name->kind != AST_IDENTIFIER || !(name->flags & (AST_FLAG_VARIABLE | AST_FLAG_SUBROUTINE)))
+    {
+        return TYPE_ERROR;
+    }
+
+    if (name->flags & AST_FLAG_VARIABLE)
+    {
+        const char *text = parser_symbol_name(checker->context, name->symbol);
+        char message[MAX_LOG_LINE];
+
+        snprintf(message, sizeof(message), "'%s' is not a procedure or function", text);
+        type_error(checker, name->offset, strlen(text), message);
+        return TYPE_ERROR;
+    }
+
+    return declared_type(name->op);
+}
+
+static void type_table_reserve(TypeTable *table, uint32_t count)
+{
+    if (count <= table->capacity)
+    {
+        return;
+    }
+
+    uint32_t capacity = table->capacity ? table->capacity : 1024;
+
+    while (capacity < count)
+    {
+        capacity = capacity > UINT32_MAX / 2 ? UINT32_MAX : capacity * 2;
+    }
+
+    uint8_t *types = (uint8_t *)realloc(table->types, capacity);
+
+    if (types == NULL)
+    {
+        perror("Error allocating type table");
+        exit(EXIT_FAILURE);
+    }
+
+    table->types = types;
+    table->capacity = capacity;
+}
+
+/**
+ * @brief Calcula o tipo dos nós de first até o último nó da árvore.
+ */
+static void check_nodes(TypeChecker *checker, AstIndex first)
+{
+    const Ast *ast = checker->ast;
+    TypeTable *table = checker->table;
+
+    type_table_reserve(table, ast->count);
+
+    // Nós que ficaram sem tipo antes de first (como o nó 0) não têm valor
+    if (table->count < first && first <= ast->count)
+    {
+        memset(table->types + table->count, TYPE_NONE, first - table->count);
+    }
+
+    for (AstIndex index = first; index < ast->count; index++)
+    {
+        const AstNode *node = ast_node(ast, index);
+        Type type = TYPE_NONE;
+
+        checker->index = index;
+
+        switch (node->kind)
+        {
+        case AST_NUMBER:
+            type = TYPE_INTEGER;
+            break;
+
+        case AST_BOOLEAN:
+            type = TYPE_BOOLEAN;
+            break;
+
+        case AST_IDENTIFIER:
+            type = identifier_type(node);
+            break;
+
+        case AST_UNARY:
+            type = check_unary(checker, node);
+            break;
+
+        case AST_BINARY:
+            type = check_binary(checker, node);
+            break;
+
+        case AST_CALL:
+            type = check_call(checker, node);
+            break;
+
+        case AST_ERROR:
+            type = TYPE_ERROR;
+            break;
+
+        case AST_ASSIGNMENT:
+            check_assignment(checker, node);
+            break;
+
+        case AST_IF:
+            check_condition(checker, node, "if");
+            break;
+
+        case AST_WHILE:
+            check_condition(checker, node, "while");
+            break;
+
+        case AST_WRITE:
+            check_write(checker, node);
+            break;
+
+        default:
+            break;
+        }
+
+        table->types[index] = type;
+    }
+
+    table->count = ast->count;
+}
+
+static void diagnostics_clear(TypeTable *table)
+{
+    for (uint32_t i = 0; i < table->diagnostic_count; i++)
+    {
+        free(table->diagnostics[i].message);
+    }
+
+    table->diagnostic_count = 0;
+}
+
+uint32_t type_check(CompilerContext *context, AstIndex first, bool report)
+{
+    TypeChecker checker = {context, parser_ast(context), &context->types, report, false, AST_NONE, 0, 0};
+
+    check_nodes(&checker, first);
+
+    return checker.errors;
+}
+
+void type_check_pending(CompilerContext *context)
+{
+    TypeTable *table = &context->types;
+    TypeChecker checker = {context, parser_ast(context), table, false, true, AST_NONE, 0, 0};
+
+    check_nodes(&checker, table->count > AST_NONE ? table->count : AST_NONE + 1);
+
+    // Todos os nós com posição guardada já foram verificados
+    table->position_count = 0;
+}
+
+uint32_t type_check_finish(CompilerContext *context, bool report)
+{
+    TypeTable *table = &context->types;
+
+    type_check_pending(context);
+
+    uint32_t errors = table->diagnostic_count;
+
+    for (uint32_t i = 0; report && i < table->diagnostic_count; i++)
+    {
+        const TypeDiagnostic *diagnostic = &table->diagnostics[i];
+        parser_semantic_error_at(context, diagnostic->offset, diagnostic->span, diagnostic->line, diagnostic->column, diagnostic->message);
+    }
+
+    diagnostics_clear(table);
+
+    return errors;
+}
+
+TypePosition type_position_at(CompilerContext *context, uint32_t offset)
+{
+    TypePosition position = {AST_NONE, 0, 0};
+
+    if (context->scanner.stream_fd >= 0)
+    {
+        line_index_locate(&context->scanner.line_index, offset, &position.line, &position.column);
+    }
+
+    return position;
+}
+
+void type_position_keep(CompilerContext *context, AstIndex node, TypePosition position)
+{
+    TypeTable *table = &context->types;
+
+    if (position.line == 0)
+    {
+        return;
+    }
+
+    if (table->position_count == table->position_capacity)
+    {
+        table->position_capacity = table->position_capacity ? table->position_capacity * 2 : 16;
+        table->positions = (TypePosition *)checked_realloc(table->positions, table->position_capacity * sizeof(TypePosition), "Error allocating type errors");
+    }
+
+    position.node = node;
+    table->positions[table->position_count++] = position;
+}
+
+void type_table_clear(TypeTable *table)
+{
+    diagnostics_clear(table);
+    table->count = 0;
+    table->position_count = 0;
+}
+
+void type_table_free(TypeTable *table)
+{
+    type_table_clear(table);
+    free(table->types);
+    free(table->diagnostics);
+    free(table->positions);
+    memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,20 @@
+program teste_dobra_de_constantes;
+var x, y : integer;
+var b : boolean;
+begin
+  x := 10 * 2 + 0;                   /* 20 */
+  y := x * 1 + ( 0 + x ) - 0;        /* x + x */
+  x := 2147483647 + 1;               /* -2147483648: a soma dá a volta em 32 bits */
+  y := -2147483647 - 1;
+  y := y div ( -1 );                 /* não é dobrado: y é variável */
+  x := 7 div 0;                      /* a divisão por zero fica para a execução */
+  x := -7 div 2;                     /* -3 */
+  b := not not ( x < y );            /* x < y */
+  b := ( 3 < 4 ) and b or false;     /* b */
+  if ( true ) then x := 1 else x := 2;
+  if false then x := 3;              /* comando vazio */
+  if 1 > 2 then x := 4 else begin x := 5; y := 6 end;
+  while false do x := x + 1;         /* comando vazio */
+  while not true or ( 2 = 3 ) do begin x := 1 end;
+  write(x, y, b)
+end.
@@ -0,0 +1,16 @@
+program teste_dobra_profunda;
+/* Ramos descartados com subárvores aninhadas. A versão com 500 mil termos é
+   gerada por tests/test_deep_folding.sh */
+var a, b : integer;
+var c : boolean;
+begin
+  if false then a := a + ( b - ( a * ( b + ( a - ( b div ( a + ( b + 1 ) ) ) ) ) ) );
+  while false do c := not ( not ( not ( a < b ) ) ) and ( c or ( a = b ) );
+  if not true then
+    begin
+      a := a + a + a + a + a + a + a + a;
+      while c do a := ( ( ( ( a ) ) ) )
+    end
+  else b := ( ( 1 + 2 ) * 3 ) + a;
+  write(a, b, c)
+end.
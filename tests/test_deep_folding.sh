@@ -0,0 +1,37 @@
+#!/bin/sh
+# Ramos descartados com expressões de 500 mil termos, subárvores com essa
+# profundidade: --fold deve removê-los sem limite de profundidade. O programa
+# tem 2 MB e é gerado aqui, em vez de ficar em tests/.
+# Uso: tests/test_deep_folding.sh [compilador]
+
+COMPILER=${1:-./compiler}
+
+output=$(awk 'BEGIN {
+    print "program teste_dobra_profunda;"
+    print "var a : integer;"
+    print "begin"
+    split("if false then,while false do", statements, ",")
+    for (s = 1; s <= 2; s++)
+    {
+        print "  " statements[s] " a := a"
+        for (line = 0; line < 5000; line++)
+        {
+            printf "  "
+            for (term = 0; term < 100; term++) printf "+a"
+            print line == 4999 ? ";" : ""
+        }
+    }
+    print "  write(a)"
+    print "end."
+}' | "$COMPILER" -q --log=none --fold - 2>&1)
+
+status=$?
+expected="Constant folding removed 2000008 nodes"
+
+if [ $status -ne 0 ] || [ "$output" != "$expected" ]; then
+    echo "test_deep_folding: expected \"$expected\", got:"
+    echo "$output"
+    exit 1
+fi
+
+echo "test_deep_folding: ok"
@@ -0,0 +1,23 @@
+program teste_erros_semanticos;
+var x, y : integer;
+var x : boolean; /* x já declarado no mesmo escopo */
+procedure p(var a : integer; var a : boolean);
+var y : boolean; /* oculta o y de fora */
+var p : integer;  /* oculta o nome da própria procedure */
+begin
+  y := true;
+  p := a + 1;
+  z := 2 /* z não declarado */
+end;
+function f(var n : integer) : integer;
+begin
+  f := n * 2
+end;
+procedure f(var m : integer); /* f já declarado */
+begin
+  m := n /* n é parâmetro de outra subrotina */
+end;
+begin
+  x := y + 1;
+  write(x, a)
+end.
@@ -0,0 +1,60 @@
+#!/bin/sh
+# Uma edição que corrige o erro de sintaxe de uma procedure deve registrar o erro
+# de tipo do programa principal, que a compilação com erros não registrou.
+# Uso: tests/test_server_edit.sh [compilador]
+
+COMPILER=${1:-./compiler}
+SOCKET=${TMPDIR:-/tmp}/test_server_edit.$$.sock
+
+"$COMPILER" --server "$SOCKET" &
+server=$!
+
+output=$(python3 - "$SOCKET" <<'PYTHON'
+import socket, sys, time
+
+for _ in range(100):
+    try:
+        connection = socket.socket(socket.AF_UNIX)
+        connection.connect(sys.argv[1])
+        break
+    except OSError:
+        time.sleep(0.05)
+
+responses = connection.makefile("rb")
+
+def request(line, payload):
+    connection.sendall(line.encode() + b"\n" + payload)
+    status, size = responses.readline().split()
+    print(status.decode(), responses.read(int(size)).decode(), end="")
+
+source = b"""program teste;
+var x : integer;
+procedure p;
+begin
+  x := 1 +
+end;
+begin
+  x := true
+end.
+"""
+
+request("source %d" % len(source), source)
+request("edit %d 2 0" % (source.index(b"1 +") + 1), b"")
+PYTHON
+)
+
+kill $server
+wait $server 2>/dev/null
+
+expected="failed Syntax Error at line 06, column 01: Unexpected token 'end' of type KEYWORD
+failed Semantic Error at line 08, column 03: Cannot assign boolean to 'x' of type integer"
+
+if [ "$output" != "$expected" ]; then
+    echo "test_server_edit: expected:"
+    echo "$expected"
+    echo "got:"
+    echo "$output"
+    exit 1
+fi
+
+echo "test_server_edit: ok"
@@ -0,0 +1,17 @@
+program teste_erros_sintaticos;
+var x, y : integer;
+var b : real; /* tipo inexistente */
+procedure q(var a : integer);
+begin
+  a := a + ;
+  if a then x := ) else y := 2
+end;
+begin
+  x := 1 +;
+  y := (2 * 3;
+  x := 3 y := 4; /* ";" ausente */
+  while x > do x := x - 1;
+  begin x := 1 end;
+  write(x, 3);
+  x = 4
+end.
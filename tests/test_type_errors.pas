@@ -0,0 +1,27 @@
+program teste_erros_de_tipo;
+var x, y : integer;
+var b : boolean;
+procedure p;
+begin
+  x := 1
+end;
+function f(var n : integer) : boolean;
+begin
+  f := n > 0
+end;
+begin
+  x := true;            /* boolean em variável integer */
+  b := x + 1;           /* integer em variável boolean */
+  x := x + b;           /* operando boolean em + */
+  b := b and (x or y);  /* operandos integer em or */
+  b := x = b;           /* tipos diferentes em = */
+  b := not x;           /* not de integer */
+  x := -b;              /* - de boolean */
+  p := 1;               /* procedure não é variável */
+  if x then y := 1;     /* condição integer */
+  while x + y do x := x - 1;
+  b := (x + b) < y;     /* só o + é registrado */
+  b := (x < y) and not b;
+  b := b and p;         /* procedure não tem valor */
+  write(x, b, p)
+end.
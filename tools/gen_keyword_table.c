@@ -0,0 +1,233 @@
+/*
+Gerador da tabela hash perfeita mínima de palavras reservadas (include/keyword_table.h).
+
+Lê as listas de src/token.c e imprime na saída padrão um cabeçalho com:
+- o deslocamento de cada balde (hash and displace);
+- a tabela final, com exatamente uma posição por lexema.
+
+Uso: make keywords
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#include "token.h"
+#include "keyword_hash.h"
+
+#define MAX_WORDS 64
+#define MAX_DISPLACEMENT 65536
+
+typedef struct
+{
+    const char *word;
+    TokenType type;
+    TokenKind kind;
+    uint32_t hash;
+} Word;
+
+static Word words[MAX_WORDS];
+static int word_count = 0;
+
+static bool is_word(const char *lexeme)
+{
+    if (!(isalpha((unsigned char)lexeme[0]) || lexeme[0] == '_'))
+    {
+        return false;
+    }
+
+    for (int i = 1; lexeme[i] != '\0'; i++)
+    {
+        if (!(isalnum((unsigned char)lexeme[i]) || lexeme[i] == '_'))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Adiciona os lexemas com forma de identificador de uma lista.
+ * Um lexema já adicionado por uma lista de maior precedência é ignorado.
+ */
+static void add_words(const char *list[], const TokenKind kinds[], int count, TokenType type)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!is_word(list[i]))
+        {
+            continue;
+        }
+
+        bool duplicated = false;
+        for (int j = 0; j < word_count; j++)
+        {
+            if (strcmp(words[j].word, list[i]) == 0)
+            {
+                duplicated = true;
+                break;
+            }
+        }
+
+        if (duplicated)
+        {
+            continue;
+        }
+
+        if (word_count == MAX_WORDS)
+        {
+            fprintf(stderr, "Too many keywords (max %d)\n", MAX_WORDS);
+            exit(EXIT_FAILURE);
+        }
+
+        words[word_count].word = list[i];
+        words[word_count].type = type;
+        words[word_count].kind = kinds[i];
+        words[word_count].hash = keyword_hash(list[i], strlen(list[i]));
+        word_count++;
+    }
+}
+
+/**
+ * Procura um deslocamento para cada balde, do maior para o menor, de forma
+ * que todos os lexemas caiam em posições distintas da tabela.
+ */
+static bool build_table(int bucket_count, int *displacements, int *slots)
+{
+    int bucket_sizes[MAX_WORDS] = {0};
+    int order[MAX_WORDS];
+    bool used[MAX_WORDS] = {false};
+
+    for (int i = 0; i < word_count; i++)
+    {
+        bucket_sizes[words[i].hash % bucket_count]++;
+    }
+
+    for (int i = 0; i < bucket_count; i++)
+    {
+        order[i] = i;
+    }
+
+    for (int i = 1; i < bucket_count; i++)
+    {
+        for (int j = i; j > 0 && bucket_sizes[order[j]] > bucket_sizes[order[j - 1]]; j--)
+        {
+            int tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+
+    for (int b = 0; b < bucket_count; b++)
+    {
+        int bucket = order[b];
+        displacements[bucket] = 0;
+
+        if (bucket_sizes[bucket] == 0)
+        {
+            continue;
+        }
+
+        bool placed = false;
+        for (int d = 0; d < MAX_DISPLACEMENT && !placed; d++)
+        {
+            bool taken[MAX_WORDS];
+            memcpy(taken, used, sizeof(taken));
+            placed = true;
+
+            for (int i = 0; i < word_count; i++)
+            {
+                if (words[i].hash % bucket_count != (uint32_t)bucket)
+                {
+                    continue;
+                }
+
+                uint32_t slot = keyword_slot(words[i].hash, d, word_count);
+                if (taken[slot])
+                {
+                    placed = false;
+                    break;
+                }
+
+                taken[slot] = true;
+                slots[i] = slot;
+            }
+
+            if (placed)
+            {
+                memcpy(used, taken, sizeof(used));
+                displacements[bucket] = d;
+            }
+        }
+
+        if (!placed)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    // Mesma precedência usada pelo analisador léxico
+    add_words(logical_operators, logical_operator_kinds, num_logical_operators, TOKEN_OPERATOR_LOGICAL);
+    add_words(arithmetic_operators, arithmetic_operator_kinds, num_arithmetic_operators, TOKEN_OPERATOR_ARITHMETIC);
+    add_words(booleans, boolean_kinds, num_booleans, TOKEN_BOOLEAN);
+    add_words(keywords, keyword_kinds, num_keywords, TOKEN_KEYWORD);
+
+    int displacements[MAX_WORDS];
+    int slots[MAX_WORDS];
+    int bucket_count = (word_count + 1) / 2;
+
+    while (!build_table(bucket_count, displacements, slots))
+    {
+        if (++bucket_count > word_count)
+        {
+            fprintf(stderr, "Could not build a perfect hash for the keyword table\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    size_t min_length = (size_t)-1;
+    size_t max_length = 0;
+    const Word *table[MAX_WORDS];
+
+    for (int i = 0; i < word_count; i++)
+    {
+        size_t length = strlen(words[i].word);
+        min_length = length < min_length ? length : min_length;
+        max_length = length > max_length ? length : max_length;
+        table[slots[i]] = &words[i];
+    }
+
+    printf("/* Gerado automaticamente por tools/gen_keyword_table.c a partir de src/token.c. Não edite. */\n\n");
+    printf("#ifndef KEYWORD_TABLE_H\n#define KEYWORD_TABLE_H\n\n");
+    printf("#include \"keyword_hash.h\"\n\n");
+    printf("#define KEYWORD_TABLE_SIZE %d\n", word_count);
+    printf("#define KEYWORD_BUCKET_COUNT %d\n", bucket_count);
+    printf("#define KEYWORD_MIN_LENGTH %zu\n", min_length);
+    printf("#define KEYWORD_MAX_LENGTH %zu\n\n", max_length);
+
+    printf("static const uint16_t keyword_displacements[KEYWORD_BUCKET_COUNT] = {");
+    for (int i = 0; i < bucket_count; i++)
+    {
+        printf("%s%d", i == 0 ? "" : ", ", displacements[i]);
+    }
+    printf("};\n\n");
+
+    printf("static const KeywordEntry keyword_table[KEYWORD_TABLE_SIZE] = {\n");
+    for (int i = 0; i < word_count; i++)
+    {
+        printf("    {\"%s\", %zu, TOKEN_%s, %s},\n", table[i]->word, strlen(table[i]->word), token_type_to_string(table[i]->type), token_kind_to_string(table[i]->kind));
+    }
+    printf("};\n\n");
+
+    printf("#endif // KEYWORD_TABLE_H\n");
+
+    return EXIT_SUCCESS;
+}